@@ -0,0 +1,397 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// =====================
+// SAMPLE RING
+// =====================
+// Single-producer single-consumer ring of floats for a block at a time,
+// audio thread -> worker. write() takes what fits and never waits; the
+// producer counts what it could not hand over. Allocate it value-
+// initialised (make_unique) so its pages are touched up front.
+template <int CAPACITY>
+class SampleRing {
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "power of two");
+
+public:
+    int write(const float* src, int n) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        uint64_t tail = tail_.load(std::memory_order_acquire);
+        n = std::min(n, int(CAPACITY - (head - tail)));
+        copyIn(head, src, n);
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    int read(float* dst, int n) {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        uint64_t head = head_.load(std::memory_order_acquire);
+        n = std::min(n, int(head - tail));
+        for (int i = 0; i < n; i++)
+            dst[i] = data_[(tail + i) & (CAPACITY - 1)];
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+private:
+    void copyIn(uint64_t head, const float* src, int n) {
+        int at = int(head & (CAPACITY - 1));
+        int first = std::min(n, CAPACITY - at);
+        std::copy(src, src + first, data_ + at);
+        std::copy(src + first, src + n, data_);
+    }
+
+    float data_[CAPACITY];
+    alignas(64) std::atomic<uint64_t> head_{0};
+    alignas(64) std::atomic<uint64_t> tail_{0};
+};
+
+// =====================
+// FFT
+// =====================
+// Radix-2 complex FFT with the twiddles and bit reversal worked out up
+// front; power() takes n real samples and gives the n/2 + 1 bin powers.
+class Fft {
+public:
+    explicit Fft(int n) : n_(n), re_(n), im_(n), cos_(n / 2), sin_(n / 2),
+                          rev_(n) {
+        int bits = 0;
+        while ((1 << bits) < n) bits++;
+        for (int i = 0; i < n; i++) {
+            int r = 0;
+            for (int b = 0; b < bits; b++)
+                if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+            rev_[i] = r;
+        }
+        for (int i = 0; i < n / 2; i++) {
+            cos_[i] = float(cos(2.0 * M_PI * i / n));
+            sin_[i] = float(-sin(2.0 * M_PI * i / n));
+        }
+    }
+
+    int size() const { return n_; }
+
+    void power(const float* in, float* out) {
+        for (int i = 0; i < n_; i++) {
+            re_[rev_[i]] = in[i];
+            im_[rev_[i]] = 0.0f;
+        }
+
+        for (int len = 2; len <= n_; len <<= 1) {
+            int half = len / 2, step = n_ / len;
+            for (int start = 0; start < n_; start += len) {
+                for (int k = 0; k < half; k++) {
+                    float wr = cos_[k * step], wi = sin_[k * step];
+                    int a = start + k, b = a + half;
+                    float tr = re_[b] * wr - im_[b] * wi;
+                    float ti = re_[b] * wi + im_[b] * wr;
+                    re_[b] = re_[a] - tr;
+                    im_[b] = im_[a] - ti;
+                    re_[a] += tr;
+                    im_[a] += ti;
+                }
+            }
+        }
+
+        for (int i = 0; i <= n_ / 2; i++)
+            out[i] = re_[i] * re_[i] + im_[i] * im_[i];
+    }
+
+private:
+    int n_;
+    std::vector<float> re_, im_, cos_, sin_;
+    std::vector<int> rev_;
+};
+
+// =====================
+// SPECTRUM HELPERS
+// =====================
+// Shared by the live analyzer and cynth-analyze.
+inline std::vector<float> hannWindow(int n) {
+    std::vector<float> w(n);
+    for (int i = 0; i < n; i++)
+        w[i] = float(0.5 - 0.5 * cos(2.0 * M_PI * i / n));
+    return w;
+}
+
+// Scale for Fft::power() of a windowed frame such that the n/2 + 1 bins
+// add up (Parseval) to the frame's mean square, so band powers compare
+// with an RMS level: a full-scale sine is -3 dB.
+inline float powerScale(const std::vector<float>& window) {
+    double energy = 0.0;
+    for (float w : window) energy += double(w) * w;
+    return float(2.0 / (double(window.size()) * energy));
+}
+
+// `bands` + 1 bin edges, log-spaced from 20 Hz to Nyquist; band b is
+// bins [edges[b], edges[b + 1]). At least one bin each where there are
+// bins to go round, so the low bands are linear.
+inline std::vector<int> logBandEdges(int fftSize, int sampleRate, int bands) {
+    int bins = fftSize / 2;
+    double lo = 20.0, hi = sampleRate / 2.0;
+    std::vector<int> edges(bands + 1);
+    for (int b = 0; b <= bands; b++) {
+        double hz = lo * pow(hi / lo, double(b) / bands);
+        edges[b] = std::clamp(int(lround(hz * fftSize / sampleRate)), 1, bins + 1);
+    }
+    for (int b = 1; b <= bands; b++)
+        edges[b] = std::min(std::max(edges[b], edges[b - 1] + 1), bins + 1);
+    return edges;
+}
+
+inline float powerToDb(double power, float floorDb = -120.0f) {
+    return power > 0.0 ? std::max(floorDb, float(10.0 * log10(power)))
+                       : floorDb;
+}
+
+// =====================
+// ANALYSIS SINKS
+// =====================
+// Where the analyzer's lines go: a file ("-" for stdout), or one UDP
+// datagram per line ("udp:HOST:PORT"), e.g. to `nc -ul PORT`.
+class AnalysisSink {
+public:
+    virtual ~AnalysisSink() = default;
+    virtual void write(const std::string& line) = 0;  // ends in '\n'
+};
+
+class FileSink : public AnalysisSink {
+public:
+    ~FileSink() override {
+        if (file_ && file_ != stdout) fclose(file_);
+    }
+
+    bool open(const std::string& path) {
+        file_ = path == "-" ? stdout : fopen(path.c_str(), "w");
+        return file_ != nullptr;
+    }
+
+    void write(const std::string& line) override {
+        fputs(line.c_str(), file_);
+        fflush(file_);
+    }
+
+private:
+    FILE* file_ = nullptr;
+};
+
+#if defined(__unix__) || defined(__APPLE__)
+class UdpSink : public AnalysisSink {
+public:
+    ~UdpSink() override {
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    bool open(const std::string& host, const std::string& port) {
+        addrinfo hints = {}, *res = nullptr;
+        hints.ai_socktype = SOCK_DGRAM;
+        if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0)
+            return false;
+        for (addrinfo* a = res; a && fd_ < 0; a = a->ai_next) {
+            fd_ = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+            if (fd_ >= 0 && connect(fd_, a->ai_addr, a->ai_addrlen) != 0) {
+                ::close(fd_);
+                fd_ = -1;
+            }
+        }
+        freeaddrinfo(res);
+        return fd_ >= 0;
+    }
+
+    // nobody listening is not an error; the next line tries again
+    void write(const std::string& line) override {
+        send(fd_, line.data(), line.size(), MSG_DONTWAIT);
+    }
+
+private:
+    int fd_ = -1;
+};
+#endif
+
+// Null (with `error` set) if `dest` cannot be opened.
+inline std::unique_ptr<AnalysisSink> openAnalysisSink(const std::string& dest,
+                                                      std::string& error) {
+#if defined(__unix__) || defined(__APPLE__)
+    if (dest.compare(0, 4, "udp:") == 0) {
+        size_t colon = dest.rfind(':');
+        auto udp = std::make_unique<UdpSink>();
+        if (colon > 4 && udp->open(dest.substr(4, colon - 4), dest.substr(colon + 1)))
+            return udp;
+        error = "cannot reach " + dest + " (udp:HOST:PORT)";
+        return nullptr;
+    }
+#endif
+    auto file = std::make_unique<FileSink>();
+    if (file->open(dest)) return file;
+    error = "cannot write " + dest;
+    return nullptr;
+}
+
+// =====================
+// ANALYZER
+// =====================
+// Master-bus tap. The audio thread push()es each callback's output into
+// a SampleRing (a copy, no locks, no waiting); a worker thread drains it
+// and every `hop` samples emits one line:
+//
+//   <seconds> <rms dB> <peak dB> <band dB> ...
+//
+// RMS and peak are over the hop just read. The bands are the power of a
+// Hann-windowed `fftSize` STFT frame (the latest samples) summed into
+// `bands` log-spaced bands from 20 Hz to Nyquist, scaled so the bands
+// add up to the frame's mean square, in dB re full scale.
+// Header lines start with '#' and give the band edges. If the worker
+// falls behind by more than the ring holds, samples are dropped on the
+// audio side and reported in a '#' line; time keeps counting analysed
+// samples.
+struct AnalyzerConfig {
+    int fftSize = 2048;
+    int hop = 512;
+    int bands = 48;
+};
+
+class Analyzer {
+public:
+    static constexpr int RING = 1 << 16;  // ~1.5 s at 44.1 kHz
+
+    ~Analyzer() { stop(); }
+
+    bool start(std::unique_ptr<AnalysisSink> sink, int sampleRate,
+               const AnalyzerConfig& config = AnalyzerConfig()) {
+        sink_ = std::move(sink);
+        sampleRate_ = sampleRate;
+        config_ = config;
+        fft_ = std::make_unique<Fft>(config.fftSize);
+        ring_ = std::make_unique<SampleRing<RING>>();
+
+        window_ = hannWindow(config.fftSize);
+        norm_ = powerScale(window_);
+        edges_ = logBandEdges(config.fftSize, sampleRate, config.bands);
+        header();
+
+        running_ = true;
+        worker_ = std::thread([this] { run(); });
+        return true;
+    }
+
+    void stop() {
+        if (!running_) return;
+        running_ = false;
+        worker_.join();
+    }
+
+    bool running() const { return running_; }
+
+    // audio thread
+    void push(const float* samples, int frames) {
+        if (!running_) return;
+        int n = ring_->write(samples, frames);
+        if (n < frames)
+            dropped_.fetch_add(uint64_t(frames - n), std::memory_order_relaxed);
+    }
+
+    uint64_t analysed() const { return analysed_; }
+    uint64_t dropped() const { return dropped_; }
+    uint64_t frames() const { return frames_; }
+
+private:
+    void header() {
+        char buf[128];
+        snprintf(buf, sizeof(buf),
+                 "# cynth analysis: rate %d, fft %d, hop %d, %d bands\n",
+                 sampleRate_, config_.fftSize, config_.hop, config_.bands);
+        std::string line = buf;
+        line += "# band edges Hz:";
+        for (int e : edges_) {
+            snprintf(buf, sizeof(buf), " %.0f", double(e) * sampleRate_ / config_.fftSize);
+            line += buf;
+        }
+        line += "\n# seconds rms_db peak_db band_db...\n";
+        sink_->write(line);
+    }
+
+    void run() {
+        const int n = config_.fftSize, hop = config_.hop;
+        std::vector<float> history(n, 0.0f), frame(n), power(n / 2 + 1);
+        std::vector<float> block(hop);
+        int filled = 0;
+        uint64_t reportedDrops = 0;
+        std::string line;
+        char buf[32];
+
+        while (running_) {
+            int got = ring_->read(block.data() + filled, hop - filled);
+            filled += got;
+            if (filled < hop) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                continue;
+            }
+            filled = 0;
+
+            double sum = 0.0;
+            float peak = 0.0f;
+            for (float x : block) {
+                sum += double(x) * x;
+                peak = std::max(peak, fabsf(x));
+            }
+
+            std::move(history.begin() + hop, history.end(), history.begin());
+            std::copy(block.begin(), block.end(), history.end() - hop);
+            for (int i = 0; i < n; i++)
+                frame[i] = history[i] * window_[i];
+            fft_->power(frame.data(), power.data());
+            analysed_ += hop;
+
+            uint64_t drops = dropped_.load(std::memory_order_relaxed);
+            if (drops != reportedDrops) {
+                snprintf(buf, sizeof(buf), "%llu", (unsigned long long)drops);
+                sink_->write(std::string("# dropped ") + buf + " samples\n");
+                reportedDrops = drops;
+            }
+
+            snprintf(buf, sizeof(buf), "%.3f %.1f %.1f",
+                     double(analysed_) / sampleRate_, powerToDb(sum / hop),
+                     powerToDb(double(peak) * peak));
+            line = buf;
+            for (int b = 0; b < config_.bands; b++) {
+                double p = 0.0;
+                for (int k = edges_[b]; k < edges_[b + 1]; k++) p += power[k];
+                snprintf(buf, sizeof(buf), " %.1f", powerToDb(p * norm_));
+                line += buf;
+            }
+            line += '\n';
+            sink_->write(line);
+            frames_++;
+        }
+    }
+
+    std::unique_ptr<AnalysisSink> sink_;
+    std::unique_ptr<Fft> fft_;
+    std::unique_ptr<SampleRing<RING>> ring_;
+    std::vector<float> window_;
+    std::vector<int> edges_;
+    float norm_ = 1.0f;
+    int sampleRate_ = 44100;
+    AnalyzerConfig config_;
+
+    std::thread worker_;
+    std::atomic<bool> running_{ false };
+    std::atomic<uint64_t> dropped_{ 0 };
+    std::atomic<uint64_t> analysed_{ 0 };
+    std::atomic<uint64_t> frames_{ 0 };
+};
@@ -0,0 +1,425 @@
+// Batch analysis of WAV files, in place of
+// experiments/analysis/scripts/plot_audio.py.
+//
+//   cmake --build build --target cynth-analyze   (see CMakeLists.txt), or
+//   g++ -O2 -std=c++20 -pthread analyze.cpp -o cynth-analyze
+//   ./cynth-analyze render.wav            -> render-*.csv, render-spectrogram.pgm
+//   ./cynth-analyze --fft 4096 --threads 4 --out /tmp/a song.wav
+//
+// The file is streamed: it is cut into chunks of CHUNK_FRAMES STFT frames,
+// a batch of one chunk per thread is analysed at a time (each thread with
+// its own reader, seeking to its chunk), and the batch's rows are written
+// out in order before the next starts. Memory is a few batches' worth
+// whatever the file length, and every result is the same for any thread
+// count. Per file it writes
+//
+//   PREFIX-spectrum.csv      hz, db: power per bin averaged over the file
+//   PREFIX-spectrogram.csv   seconds, rms_db, peak_db, one column per band
+//                            (one row per hop, as synth --analyze)
+//   PREFIX-spectrogram.pgm   the same as an image, high bands on top,
+//                            -100..0 dB as black..white (any converter
+//                            turns it into a PNG)
+//   PREFIX-onsets.csv        seconds, strength: spectral-flux peaks
+//
+// and prints peak, RMS and onset count. PREFIX defaults to the input
+// path without ".wav".
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "analysis.h"
+#include "wav.h"
+
+constexpr int CHUNK_FRAMES = 256;  // STFT frames per job
+constexpr float IMAGE_FLOOR_DB = -100.0f;
+
+struct Options {
+    int fftSize = 2048;
+    int hop = 512;
+    int bands = 48;
+    int threads = std::max(1, int(std::thread::hardware_concurrency()));
+    int imageWidth = 1200;
+    int imageHeight = 256;
+    std::string out;
+};
+
+// =====================
+// CHUNK ANALYSIS
+// =====================
+// STFT frame f ends with hop f: it covers samples
+// [(f + 1) * hop - fftSize, (f + 1) * hop), zeros before the start.
+struct ChunkResult {
+    int64_t firstFrame = 0;
+    int frames = 0;
+    std::vector<float> rows;       // frames x (2 + bands): rms, peak, bands
+    std::vector<float> flux;       // per frame
+    std::vector<double> spectrum;  // summed bin power
+    std::vector<float> image;      // imageHeight per frame, dB
+    double sumSquares = 0.0;
+    float peak = 0.0f;
+};
+
+struct Analysis {
+    const Options& opt;
+    std::string path;
+    int sampleRate = 0;
+    int64_t totalFrames = 0;       // STFT frames
+    std::vector<float> window;
+    float scale = 1.0f;
+    std::vector<int> bandEdges, imageEdges;
+
+    void analyseChunk(WavReader& wav, Fft& fft, ChunkResult& r) const {
+        const int n = opt.fftSize, hop = opt.hop, bins = n / 2 + 1;
+        int stride = 2 + opt.bands;
+
+        // one frame before the chunk as well, for its flux
+        int64_t from = r.firstFrame - 1;
+        int64_t startSample = (from + 1) * hop - n;
+        int64_t endSample = (r.firstFrame + r.frames) * hop;
+
+        std::vector<float> samples(size_t(endSample - startSample), 0.0f);
+        int64_t readFrom = std::max<int64_t>(0, startSample);
+        wav.seek(readFrom);
+        wav.read(samples.data() + (readFrom - startSample),
+                 int(endSample - readFrom));
+
+        r.rows.assign(size_t(r.frames) * stride, 0.0f);
+        r.flux.assign(r.frames, 0.0f);
+        r.spectrum.assign(bins, 0.0);
+        r.image.assign(size_t(r.frames) * opt.imageHeight, 0.0f);
+
+        std::vector<float> frame(n), power(bins), mag(bins), prevMag(bins, 0.0f);
+        for (int64_t f = from; f < r.firstFrame + r.frames; f++) {
+            const float* x = samples.data() + ((f + 1) * hop - n - startSample);
+            for (int i = 0; i < n; i++)
+                frame[i] = x[i] * window[i];
+            fft.power(frame.data(), power.data());
+
+            // log-compressed magnitudes; flux is their summed rise
+            float rise = 0.0f;
+            for (int k = 0; k < bins; k++) {
+                mag[k] = log1pf(100.0f * sqrtf(power[k] * scale));
+                rise += std::max(0.0f, mag[k] - prevMag[k]);
+            }
+            std::swap(mag, prevMag);
+            if (f < r.firstFrame) continue;  // only the flux reference
+
+            int i = int(f - r.firstFrame);
+            r.flux[i] = rise;
+            for (int k = 0; k < bins; k++)
+                r.spectrum[k] += power[k];
+
+            // levels over the frame's newest hop
+            const float* newest = x + n - hop;
+            double sum = 0.0;
+            float peak = 0.0f;
+            for (int j = 0; j < hop; j++) {
+                sum += double(newest[j]) * newest[j];
+                peak = std::max(peak, fabsf(newest[j]));
+            }
+            r.sumSquares += sum;
+            r.peak = std::max(r.peak, peak);
+
+            float* row = &r.rows[size_t(i) * stride];
+            row[0] = powerToDb(sum / hop);
+            row[1] = powerToDb(double(peak) * peak);
+            bandDb(power, bandEdges, row + 2);
+            bandDb(power, imageEdges, &r.image[size_t(i) * opt.imageHeight]);
+        }
+    }
+
+    void bandDb(const std::vector<float>& power, const std::vector<int>& edges,
+                float* out) const {
+        for (size_t b = 0; b + 1 < edges.size(); b++) {
+            double p = 0.0;
+            for (int k = edges[b]; k < edges[b + 1]; k++) p += power[k];
+            out[b] = powerToDb(p * scale);
+        }
+    }
+};
+
+// =====================
+// ONSETS
+// =====================
+// Peaks of the spectral flux that stand out from its local mean (over
+// +-WINDOW_SEC) and are the largest within +-PEAK_SEC, at least GAP_SEC
+// apart. Streams with a WINDOW_SEC delay.
+class OnsetPicker {
+public:
+    static constexpr double WINDOW_SEC = 0.1;
+    static constexpr double PEAK_SEC = 0.03;
+    static constexpr double GAP_SEC = 0.05;
+    static constexpr float RATIO = 1.5f;
+
+    OnsetPicker(int sampleRate, int hop, FILE* out)
+        : hopSec_(double(hop) / sampleRate), out_(out) {
+        window_ = std::max(1, int(WINDOW_SEC / hopSec_));
+        peak_ = std::max(1, int(PEAK_SEC / hopSec_));
+    }
+
+    void push(float flux) {
+        recent_.push_back(flux);
+        sum_ += flux;
+        while (decided_ + window_ < base_ + int64_t(recent_.size()))
+            decide();
+    }
+
+    // the last frames, with what is left of their window
+    void finish() {
+        while (decided_ < base_ + int64_t(recent_.size()))
+            decide();
+    }
+
+    int count() const { return count_; }
+
+private:
+    // frame decided_ against recent_, which holds up to +-window_ of it
+    void decide() {
+        int64_t f = decided_++;
+        int at = int(f - base_);
+        float v = recent_[at];
+        float mean = float(sum_ / recent_.size());
+
+        bool onset = v > RATIO * mean && v > 1e-3f;
+        for (int d = -peak_; onset && d <= peak_; d++) {
+            int j = at + d;
+            if (d != 0 && j >= 0 && j < int(recent_.size()) && recent_[j] > v)
+                onset = false;
+        }
+        double t = f * hopSec_;
+        if (onset && (count_ == 0 || t - last_ >= GAP_SEC)) {
+            last_ = t;
+            count_++;
+            fprintf(out_, "%.4f,%.3f\n", t, v);
+        }
+
+        while (base_ < decided_ - window_) {
+            sum_ -= recent_.front();
+            recent_.pop_front();
+            base_++;
+        }
+    }
+
+    double hopSec_;
+    FILE* out_;
+    int window_, peak_;
+    std::deque<float> recent_;
+    double sum_ = 0.0;
+    int64_t base_ = 0;     // frame of recent_.front()
+    int64_t decided_ = 0;
+    int count_ = 0;
+    double last_ = 0.0;
+};
+
+// =====================
+// FILE
+// =====================
+FILE* openCsv(const std::string& path, const char* header) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (f) fprintf(f, "%s\n", header);
+    else std::cerr << "cannot write " << path << "\n";
+    return f;
+}
+
+bool analyseFile(const std::string& path, const Options& opt) {
+    WavReader probe;
+    if (!probe.open(path.c_str())) {
+        std::cerr << path << ": not a PCM or float WAV\n";
+        return false;
+    }
+
+    Analysis a{ opt, path };
+    a.sampleRate = probe.sampleRate();
+    a.totalFrames = probe.frames() / opt.hop;
+    a.window = hannWindow(opt.fftSize);
+    a.scale = powerScale(a.window);
+    a.bandEdges = logBandEdges(opt.fftSize, a.sampleRate, opt.bands);
+    a.imageEdges = logBandEdges(opt.fftSize, a.sampleRate, opt.imageHeight);
+
+    std::string prefix = opt.out;
+    if (prefix.empty()) {
+        prefix = path;
+        if (prefix.size() > 4 && prefix.compare(prefix.size() - 4, 4, ".wav") == 0)
+            prefix.resize(prefix.size() - 4);
+    }
+
+    std::string header = "seconds,rms_db,peak_db";
+    for (int b = 0; b < opt.bands; b++) {
+        char buf[24];
+        snprintf(buf, sizeof(buf), ",%.0fhz",
+                 double(a.bandEdges[b]) * a.sampleRate / opt.fftSize);
+        header += buf;
+    }
+    FILE* rowsCsv = openCsv(prefix + "-spectrogram.csv", header.c_str());
+    FILE* onsetsCsv = openCsv(prefix + "-onsets.csv", "seconds,strength");
+    if (!rowsCsv || !onsetsCsv) return false;
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    const int bins = opt.fftSize / 2 + 1;
+    const int width = int(std::min<int64_t>(opt.imageWidth, a.totalFrames));
+    std::vector<double> spectrum(bins, 0.0);
+    std::vector<float> image(size_t(width) * opt.imageHeight, IMAGE_FLOOR_DB);
+    double sumSquares = 0.0;
+    float peak = 0.0f;
+    OnsetPicker onsets(a.sampleRate, opt.hop, onsetsCsv);
+
+    int64_t chunks = (a.totalFrames + CHUNK_FRAMES - 1) / CHUNK_FRAMES;
+    std::vector<ChunkResult> batch(opt.threads);
+    std::vector<WavReader> readers(opt.threads);
+    std::vector<std::unique_ptr<Fft>> ffts;
+    for (int t = 0; t < opt.threads; t++) {
+        readers[t].open(path.c_str());
+        ffts.push_back(std::make_unique<Fft>(opt.fftSize));
+    }
+
+    for (int64_t c0 = 0; c0 < chunks; c0 += opt.threads) {
+        int inBatch = int(std::min<int64_t>(opt.threads, chunks - c0));
+
+        std::vector<std::thread> pool;
+        for (int t = 0; t < inBatch; t++) {
+            ChunkResult& r = batch[t];
+            r.firstFrame = (c0 + t) * CHUNK_FRAMES;
+            r.frames = int(std::min<int64_t>(CHUNK_FRAMES, a.totalFrames - r.firstFrame));
+            auto job = [&a, &r, &reader = readers[t], &fft = *ffts[t]] {
+                a.analyseChunk(reader, fft, r);
+            };
+            if (t + 1 < inBatch) pool.emplace_back(job);
+            else job();
+        }
+        for (std::thread& t : pool)
+            t.join();
+
+        // merged in chunk order, so the sums do not depend on threads
+        for (int t = 0; t < inBatch; t++) {
+            const ChunkResult& r = batch[t];
+            for (int k = 0; k < bins; k++)
+                spectrum[k] += r.spectrum[k];
+            sumSquares += r.sumSquares;
+            peak = std::max(peak, r.peak);
+
+            int stride = 2 + opt.bands;
+            for (int i = 0; i < r.frames; i++) {
+                int64_t f = r.firstFrame + i;
+                const float* row = &r.rows[size_t(i) * stride];
+                fprintf(rowsCsv, "%.4f", double((f + 1) * opt.hop) / a.sampleRate);
+                for (int j = 0; j < stride; j++)
+                    fprintf(rowsCsv, ",%.1f", row[j]);
+                fputc('\n', rowsCsv);
+
+                onsets.push(r.flux[i]);
+
+                // each image column keeps the loudest of its frames
+                float* column = &image[size_t(f * width / a.totalFrames) * opt.imageHeight];
+                const float* bands = &r.image[size_t(i) * opt.imageHeight];
+                for (int b = 0; b < opt.imageHeight; b++)
+                    column[b] = std::max(column[b], bands[b]);
+            }
+        }
+    }
+    onsets.finish();
+    fclose(rowsCsv);
+    fclose(onsetsCsv);
+
+    double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - t0).count();
+
+    if (FILE* f = openCsv(prefix + "-spectrum.csv", "hz,db")) {
+        for (int k = 0; k < bins; k++)
+            fprintf(f, "%.2f,%.2f\n", double(k) * a.sampleRate / opt.fftSize,
+                    powerToDb(a.totalFrames ? spectrum[k] * a.scale / a.totalFrames : 0.0));
+        fclose(f);
+    }
+
+    std::string pgm = prefix + "-spectrogram.pgm";
+    if (FILE* f = fopen(pgm.c_str(), "wb")) {
+        fprintf(f, "P5\n%d %d\n255\n", width, opt.imageHeight);
+        std::vector<unsigned char> line(width);
+        for (int b = opt.imageHeight - 1; b >= 0; b--) {
+            for (int x = 0; x < width; x++) {
+                float db = image[size_t(x) * opt.imageHeight + b];
+                line[x] = (unsigned char)std::clamp(
+                    255.0f * (1.0f - db / IMAGE_FLOOR_DB), 0.0f, 255.0f);
+            }
+            fwrite(line.data(), 1, width, f);
+        }
+        fclose(f);
+    }
+
+    double seconds = double(probe.frames()) / a.sampleRate;
+    double analysed = double(a.totalFrames) * opt.hop;
+    std::cout << std::fixed << std::setprecision(2) << path << ": "
+              << seconds << " s, " << probe.channels() << " ch, "
+              << a.sampleRate << " Hz\n"
+              << "  peak " << powerToDb(double(peak) * peak) << " dBFS, rms "
+              << powerToDb(analysed > 0 ? sumSquares / analysed : 0.0)
+              << " dBFS, " << onsets.count() << " onsets\n"
+              << "  " << a.totalFrames << " frames on " << opt.threads
+              << " thread(s) in " << std::setprecision(0) << ms << " ms ("
+              << seconds * 1000.0 / ms << "x realtime) -> " << prefix
+              << "-{spectrum,spectrogram,onsets}.csv, " << pgm << "\n";
+    return true;
+}
+
+// =====================
+// MAIN
+// =====================
+void usage() {
+    std::cerr <<
+        "usage: cynth-analyze [--fft N] [--hop N] [--bands N] [--threads N]\n"
+        "                     [--width PX] [--height PX] [--out PREFIX] "
+        "FILE.wav...\n";
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (argv[i][0] != '-') {
+            files.push_back(argv[i]);
+            continue;
+        }
+        if (!value) {
+            usage();
+            return 1;
+        }
+
+        if (strcmp(argv[i], "--fft") == 0) opt.fftSize = atoi(value);
+        else if (strcmp(argv[i], "--hop") == 0) opt.hop = atoi(value);
+        else if (strcmp(argv[i], "--bands") == 0) opt.bands = atoi(value);
+        else if (strcmp(argv[i], "--threads") == 0) opt.threads = std::max(1, atoi(value));
+        else if (strcmp(argv[i], "--width") == 0) opt.imageWidth = std::max(1, atoi(value));
+        else if (strcmp(argv[i], "--height") == 0) opt.imageHeight = std::max(1, atoi(value));
+        else if (strcmp(argv[i], "--out") == 0) opt.out = value;
+        else {
+            usage();
+            return 1;
+        }
+        i++;
+    }
+
+    bool pow2 = opt.fftSize >= 64 && (opt.fftSize & (opt.fftSize - 1)) == 0;
+    if (files.empty() || !pow2 || opt.hop < 1 || opt.hop > opt.fftSize
+        || opt.bands < 1 || (!opt.out.empty() && files.size() > 1)) {
+        if (!pow2) std::cerr << "--fft must be a power of two >= 64\n";
+        if (files.size() > 1 && !opt.out.empty())
+            std::cerr << "--out takes one file\n";
+        usage();
+        return 1;
+    }
+
+    int failed = 0;
+    for (const std::string& f : files)
+        failed += !analyseFile(f, opt);
+    return failed ? 1 : 0;
+}
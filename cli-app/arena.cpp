@@ -0,0 +1,110 @@
+#include "arena.h"
+
+#ifdef CYNTH_ALLOC_GUARD
+
+#include <cstdio>
+#include <cstring>
+
+#include <unistd.h>
+
+// =====================
+// NO-ALLOCATION GUARD
+// =====================
+// Depth of NoAllocScopes on this thread, checked by every replacement
+// below.
+static thread_local int noAllocDepth = 0;
+
+NoAllocScope::NoAllocScope() { noAllocDepth++; }
+NoAllocScope::~NoAllocScope() { noAllocDepth--; }
+
+// formatted by hand: snprintf may allocate, and we are about to abort
+[[noreturn]] static void heapInAudioThread(const char* what, size_t bytes) {
+    char msg[128] = "cynth: ";
+    strcat(msg, what);
+    strcat(msg, " in a NoAllocScope (audio callback), ");
+    char digits[24];
+    int n = 0;
+    do {
+        digits[n++] = char('0' + bytes % 10);
+        bytes /= 10;
+    } while (bytes && n < 20);
+    size_t len = strlen(msg);
+    while (n) msg[len++] = digits[--n];
+    memcpy(msg + len, " bytes\n", 8);
+    ssize_t ignored = write(STDERR_FILENO, msg, strlen(msg));
+    (void)ignored;
+    abort();
+}
+
+// The C allocator too, where the real one can be reached underneath
+// (glibc's __libc_*); operator new below goes through it as well.
+#ifdef __GLIBC__
+extern "C" {
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+void __libc_free(void*);
+
+void* malloc(size_t n) {
+    if (noAllocDepth > 0) heapInAudioThread("malloc", n);
+    return __libc_malloc(n);
+}
+
+void* calloc(size_t count, size_t n) {
+    if (noAllocDepth > 0) heapInAudioThread("calloc", count * n);
+    return __libc_calloc(count, n);
+}
+
+void* realloc(void* p, size_t n) {
+    if (noAllocDepth > 0) heapInAudioThread("realloc", n);
+    return __libc_realloc(p, n);
+}
+
+void free(void* p) {
+    if (p && noAllocDepth > 0) heapInAudioThread("free", 0);
+    __libc_free(p);
+}
+}
+#endif
+
+static void* allocate(size_t bytes, size_t align, bool nothrow) {
+    if (noAllocDepth > 0) heapInAudioThread("operator new", bytes);
+    void* p = align > alignof(std::max_align_t)
+        ? aligned_alloc(align, (bytes + align - 1) / align * align)
+        : malloc(bytes ? bytes : 1);
+    if (!p && !nothrow) throw std::bad_alloc();
+    return p;
+}
+
+static void release(void* p) {
+    if (p && noAllocDepth > 0) heapInAudioThread("operator delete", 0);
+    free(p);
+}
+
+void* operator new(size_t n) { return allocate(n, 0, false); }
+void* operator new[](size_t n) { return allocate(n, 0, false); }
+void* operator new(size_t n, const std::nothrow_t&) noexcept { return allocate(n, 0, true); }
+void* operator new[](size_t n, const std::nothrow_t&) noexcept { return allocate(n, 0, true); }
+void* operator new(size_t n, std::align_val_t a) { return allocate(n, size_t(a), false); }
+void* operator new[](size_t n, std::align_val_t a) { return allocate(n, size_t(a), false); }
+void* operator new(size_t n, std::align_val_t a, const std::nothrow_t&) noexcept {
+    return allocate(n, size_t(a), true);
+}
+void* operator new[](size_t n, std::align_val_t a, const std::nothrow_t&) noexcept {
+    return allocate(n, size_t(a), true);
+}
+
+void operator delete(void* p) noexcept { release(p); }
+void operator delete[](void* p) noexcept { release(p); }
+void operator delete(void* p, size_t) noexcept { release(p); }
+void operator delete[](void* p, size_t) noexcept { release(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { release(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { release(p); }
+void operator delete(void* p, std::align_val_t) noexcept { release(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { release(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { release(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { release(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { release(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { release(p); }
+
+#endif
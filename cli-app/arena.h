@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+// =====================
+// ARENA
+// =====================
+// One block of memory, allocated (and touched) up front, handed out by
+// bumping an offset. Nothing is freed on its own: rewind() to a mark
+// drops everything allocated after it, reset() drops the lot. Use it for
+// scratch whose lifetime is a block, a note or a job; an ArenaScope
+// rewinds on the way out. Running out returns null and is counted,
+// rather than falling back on the heap.
+class Arena {
+public:
+    static constexpr size_t ALIGN = 64;
+
+    Arena() = default;
+    explicit Arena(size_t bytes) { allocate(bytes); }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // outside the audio thread, before it runs
+    void allocate(size_t bytes) {
+        capacity_ = (bytes + ALIGN - 1) / ALIGN * ALIGN;
+        base_.reset(static_cast<uint8_t*>(::operator new(capacity_, std::align_val_t(ALIGN))));
+        for (size_t i = 0; i < capacity_; i += 4096)
+            base_[i] = 0;
+        used_ = peak_ = 0;
+    }
+
+    // `n` uninitialised Ts, ALIGN-aligned; null when full
+    template <typename T>
+    T* alloc(size_t n = 1) {
+        size_t start = (used_ + ALIGN - 1) / ALIGN * ALIGN;
+        if (start + n * sizeof(T) > capacity_) {
+            failures_++;
+            return nullptr;
+        }
+        used_ = start + n * sizeof(T);
+        peak_ = std::max(peak_, used_);
+        return reinterpret_cast<T*>(base_.get() + start);
+    }
+
+    size_t mark() const { return used_; }
+    void rewind(size_t mark) { used_ = mark; }
+    void reset() { used_ = 0; }
+
+    size_t capacity() const { return capacity_; }
+    size_t used() const { return used_; }
+    size_t peak() const { return peak_; }           // high-water mark
+    uint64_t failures() const { return failures_; } // allocs that did not fit
+
+private:
+    struct Free {
+        void operator()(uint8_t* p) const {
+            ::operator delete(p, std::align_val_t(ALIGN));
+        }
+    };
+
+    std::unique_ptr<uint8_t[], Free> base_;
+    size_t capacity_ = 0;
+    size_t used_ = 0;
+    size_t peak_ = 0;
+    uint64_t failures_ = 0;
+};
+
+class ArenaScope {
+public:
+    explicit ArenaScope(Arena& arena) : arena_(arena), mark_(arena.mark()) {}
+    ~ArenaScope() { arena_.rewind(mark_); }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+    Arena& arena_;
+    size_t mark_;
+};
+
+// =====================
+// NO-ALLOCATION GUARD
+// =====================
+// The audio callback must not touch the heap: malloc can lock and page
+// fault. Built with CYNTH_ALLOC_GUARD (CMake turns it on in Debug), the
+// core library replaces the global operator new/delete and, on glibc,
+// malloc/calloc/realloc/free; any of them on a thread inside a
+// NoAllocScope prints what happened and aborts. Without it a
+// NoAllocScope costs nothing. With another C library only operator
+// new/delete are caught.
+#ifdef CYNTH_ALLOC_GUARD
+struct NoAllocScope {
+    NoAllocScope();
+    ~NoAllocScope();
+
+    NoAllocScope(const NoAllocScope&) = delete;
+    NoAllocScope& operator=(const NoAllocScope&) = delete;
+};
+#else
+struct NoAllocScope {
+    NoAllocScope() {}
+};
+#endif
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+// =====================
+// AUDIO BACKEND
+// =====================
+// Where the engine's samples go. A backend owns the device (or file) and
+// the thread that drives it, and asks `render` for `frames` mono float
+// samples at a time; render overwrites the buffer it is given. The
+// mmap'd ALSA and the JACK backends hand it device memory directly.
+//
+// Backends are compiled in by flag (CYNTH_ALSA, CYNTH_JACK, and
+// CYNTH_NO_PORTAUDIO to leave PortAudio out); null and file are always
+// there. See backends/registry.h.
+using RenderFn = void (*)(float* out, int frames);
+
+struct AudioConfig {
+    int sampleRate = 44100;
+    int periodFrames = 256;  // frames per callback / period
+    int periods = 2;         // periods in the device buffer
+    std::string device;      // backend-specific; empty = default
+};
+
+// What a sample rendered now waits before it is heard. bufferMs is the
+// queue the backend keeps (periods x period); outputMs is what the
+// device or server reports on top, when it reports anything.
+struct AudioLatency {
+    int periodFrames = 0;
+    int periods = 0;
+    double bufferMs = 0.0;
+    double outputMs = 0.0;
+    bool reported = false;  // outputMs came from the device
+
+    // a key press waits up to one period for the next render, then the
+    // whole output path
+    double worstKeyToSoundMs(int sampleRate) const {
+        return 1000.0 * periodFrames / sampleRate
+             + (reported ? outputMs : bufferMs);
+    }
+};
+
+class AudioBackend {
+public:
+    virtual ~AudioBackend() = default;
+
+    virtual const char* name() const = 0;
+
+    // false on failure, with the reason in error()
+    virtual bool open(const AudioConfig& config, RenderFn render) = 0;
+    virtual bool start() = 0;
+    virtual void stop() = 0;
+
+    // valid after start(); may refine while running
+    virtual AudioLatency latency() const = 0;
+
+    // underruns seen so far, where the backend can tell
+    virtual int xruns() const { return 0; }
+
+    const std::string& error() const { return error_; }
+
+protected:
+    std::string error_;
+};
+
+struct BackendInfo {
+    const char* name;
+    const char* description;
+    std::unique_ptr<AudioBackend> (*create)();
+};
+
+template <typename T>
+std::unique_ptr<AudioBackend> makeBackend() {
+    return std::make_unique<T>();
+}
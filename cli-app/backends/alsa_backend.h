@@ -0,0 +1,181 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <alsa/asoundlib.h>
+
+#include "../audio_backend.h"
+
+// =====================
+// ALSA (mmap)
+// =====================
+// Native ALSA with MMAP_INTERLEAVED access: each period is rendered
+// straight into the ring buffer snd_pcm_mmap_begin exposes, so there is
+// no copy and no intermediate buffering, and the period size and count
+// are exactly what was asked for (or the nearest the device takes).
+// Works on any PCM that supports mmap, including the snd-dummy card
+// (`--device hw:Dummy`) and the `null` plugin, so it can run without
+// hardware.
+class AlsaBackend : public AudioBackend {
+public:
+    ~AlsaBackend() override {
+        stop();
+        if (pcm_) snd_pcm_close(pcm_);
+    }
+
+    const char* name() const override { return "alsa"; }
+
+    bool open(const AudioConfig& config, RenderFn render) override {
+        config_ = config;
+        render_ = render;
+
+        const char* device =
+            config.device.empty() ? "default" : config.device.c_str();
+        int err = snd_pcm_open(&pcm_, device, SND_PCM_STREAM_PLAYBACK, 0);
+        if (err < 0) return fail("open", err);
+
+        // --- hardware: mmap, float mono, rate, period size and count ---
+        snd_pcm_hw_params_t* hw;
+        snd_pcm_hw_params_alloca(&hw);
+        snd_pcm_hw_params_any(pcm_, hw);
+
+        if ((err = snd_pcm_hw_params_set_access(
+                 pcm_, hw, SND_PCM_ACCESS_MMAP_INTERLEAVED)) < 0)
+            return fail("mmap access", err);
+        if ((err = snd_pcm_hw_params_set_format(
+                 pcm_, hw, SND_PCM_FORMAT_FLOAT)) < 0)
+            return fail("float format", err);
+        if ((err = snd_pcm_hw_params_set_channels(pcm_, hw, 1)) < 0)
+            return fail("mono", err);
+
+        unsigned rate = config.sampleRate;
+        if ((err = snd_pcm_hw_params_set_rate(pcm_, hw, rate, 0)) < 0)
+            return fail("sample rate", err);
+
+        snd_pcm_uframes_t period = config.periodFrames;
+        unsigned periods = config.periods;
+        if ((err = snd_pcm_hw_params_set_period_size_near(
+                 pcm_, hw, &period, nullptr)) < 0)
+            return fail("period size", err);
+        if ((err = snd_pcm_hw_params_set_periods_near(
+                 pcm_, hw, &periods, nullptr)) < 0)
+            return fail("period count", err);
+        if ((err = snd_pcm_hw_params(pcm_, hw)) < 0)
+            return fail("hw params", err);
+
+        snd_pcm_hw_params_get_period_size(hw, &period_, nullptr);
+        snd_pcm_hw_params_get_buffer_size(hw, &buffer_);
+
+        // --- software: start once the buffer is full, wake per period ---
+        snd_pcm_sw_params_t* sw;
+        snd_pcm_sw_params_alloca(&sw);
+        snd_pcm_sw_params_current(pcm_, sw);
+        snd_pcm_sw_params_set_start_threshold(pcm_, sw, buffer_);
+        snd_pcm_sw_params_set_avail_min(pcm_, sw, period_);
+        if ((err = snd_pcm_sw_params(pcm_, sw)) < 0)
+            return fail("sw params", err);
+
+        scratch_.assign(period_, 0.0f);
+        return true;
+    }
+
+    bool start() override {
+        int err = snd_pcm_prepare(pcm_);
+        if (err < 0) return fail("prepare", err);
+        running_ = true;
+        thread_ = std::thread([this] { run(); });
+        return true;
+    }
+
+    void stop() override {
+        if (!running_) return;
+        running_ = false;
+        thread_.join();
+        snd_pcm_drop(pcm_);
+    }
+
+    AudioLatency latency() const override {
+        AudioLatency l;
+        l.periodFrames = int(period_);
+        l.periods = period_ ? int(buffer_ / period_) : 0;
+        l.bufferMs = 1000.0 * buffer_ / config_.sampleRate;
+        long delay = delay_;
+        if (delay > 0) {
+            l.outputMs = 1000.0 * delay / config_.sampleRate;
+            l.reported = true;
+        }
+        return l;
+    }
+
+    int xruns() const override { return xruns_; }
+
+private:
+    void run() {
+        while (running_) {
+            snd_pcm_sframes_t avail = snd_pcm_avail_update(pcm_);
+            if (avail < 0) {
+                recover(int(avail));
+                continue;
+            }
+            if (avail < snd_pcm_sframes_t(period_)) {
+                if (snd_pcm_wait(pcm_, 100) < 0)
+                    recover(-EPIPE);
+                continue;
+            }
+
+            const snd_pcm_channel_area_t* areas;
+            snd_pcm_uframes_t offset;
+            snd_pcm_uframes_t frames = period_;
+            int err = snd_pcm_mmap_begin(pcm_, &areas, &offset, &frames);
+            if (err < 0) {
+                recover(err);
+                continue;
+            }
+
+            // interleaved mono float: the area is a plain float array
+            // unless the driver pads frames
+            char* base = (char*)areas[0].addr + areas[0].first / 8;
+            unsigned step = areas[0].step / 8;
+            if (step == sizeof(float)) {
+                render_((float*)(base + offset * step), int(frames));
+            } else {
+                render_(scratch_.data(), int(frames));
+                for (snd_pcm_uframes_t i = 0; i < frames; i++)
+                    *(float*)(base + (offset + i) * step) = scratch_[i];
+            }
+
+            snd_pcm_sframes_t done = snd_pcm_mmap_commit(pcm_, offset, frames);
+            if (done < 0 || snd_pcm_uframes_t(done) != frames)
+                recover(done < 0 ? int(done) : -EPIPE);
+
+            snd_pcm_sframes_t delay;
+            if (snd_pcm_delay(pcm_, &delay) == 0)
+                delay_ = long(delay);
+        }
+    }
+
+    void recover(int err) {
+        xruns_++;
+        if (snd_pcm_recover(pcm_, err, 1) < 0)
+            snd_pcm_prepare(pcm_);
+    }
+
+    bool fail(const char* what, int err) {
+        error_ = std::string("alsa ") + what + ": " + snd_strerror(err);
+        return false;
+    }
+
+    AudioConfig config_;
+    RenderFn render_ = nullptr;
+    snd_pcm_t* pcm_ = nullptr;
+    snd_pcm_uframes_t period_ = 0;
+    snd_pcm_uframes_t buffer_ = 0;
+    std::vector<float> scratch_;
+
+    std::thread thread_;
+    std::atomic<bool> running_{ false };
+    std::atomic<long> delay_{ 0 };
+    std::atomic<int> xruns_{ 0 };
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include <jack/jack.h>
+
+#include "../audio_backend.h"
+
+// =====================
+// JACK
+// =====================
+// One output port, "cynth:out", connected to the first two physical
+// playback ports. The process callback renders straight into the port
+// buffer. JACK runs the graph at its own rate and period: the rate must
+// match the engine's; the period is the server's (-p), not ours.
+class JackBackend : public AudioBackend {
+public:
+    ~JackBackend() override {
+        stop();
+        if (client_) jack_client_close(client_);
+    }
+
+    const char* name() const override { return "jack"; }
+
+    bool open(const AudioConfig& config, RenderFn render) override {
+        config_ = config;
+        render_ = render;
+
+        const char* clientName =
+            config.device.empty() ? "cynth" : config.device.c_str();
+        jack_status_t status;
+        client_ = jack_client_open(clientName, JackNoStartServer, &status);
+        if (!client_) {
+            error_ = "jack: no server running";
+            return false;
+        }
+
+        if (int(jack_get_sample_rate(client_)) != config.sampleRate) {
+            error_ = "jack: server runs at "
+                   + std::to_string(jack_get_sample_rate(client_))
+                   + " Hz, engine needs "
+                   + std::to_string(config.sampleRate);
+            return false;
+        }
+
+        port_ = jack_port_register(client_, "out", JACK_DEFAULT_AUDIO_TYPE,
+                                   JackPortIsOutput, 0);
+        if (!port_) {
+            error_ = "jack: cannot register port";
+            return false;
+        }
+
+        jack_set_process_callback(client_, process, this);
+        jack_set_xrun_callback(client_, xrun, this);
+        return true;
+    }
+
+    bool start() override {
+        if (jack_activate(client_) != 0) {
+            error_ = "jack: cannot activate";
+            return false;
+        }
+        active_ = true;
+
+        const char** ports = jack_get_ports(
+            client_, nullptr, JACK_DEFAULT_AUDIO_TYPE,
+            JackPortIsPhysical | JackPortIsInput);
+        if (ports) {
+            for (int i = 0; i < 2 && ports[i]; i++)
+                jack_connect(client_, jack_port_name(port_), ports[i]);
+            jack_free(ports);
+        }
+        return true;
+    }
+
+    void stop() override {
+        if (active_) jack_deactivate(client_);
+        active_ = false;
+    }
+
+    AudioLatency latency() const override {
+        AudioLatency l;
+        if (!client_) return l;
+
+        l.periodFrames = int(jack_get_buffer_size(client_));
+        l.periods = 1;
+        l.bufferMs = 1000.0 * l.periodFrames / config_.sampleRate;
+
+        jack_latency_range_t range;
+        jack_port_get_latency_range(port_, JackPlaybackLatency, &range);
+        if (range.max > 0) {
+            l.outputMs = 1000.0 * range.max / config_.sampleRate;
+            l.reported = true;
+        }
+        return l;
+    }
+
+    int xruns() const override { return xruns_; }
+
+private:
+    static int process(jack_nframes_t frames, void* user) {
+        JackBackend* self = (JackBackend*)user;
+        float* out = (float*)jack_port_get_buffer(self->port_, frames);
+        self->render_(out, int(frames));
+        return 0;
+    }
+
+    static int xrun(void* user) {
+        ((JackBackend*)user)->xruns_++;
+        return 0;
+    }
+
+    AudioConfig config_;
+    RenderFn render_ = nullptr;
+    jack_client_t* client_ = nullptr;
+    jack_port_t* port_ = nullptr;
+    bool active_ = false;
+    std::atomic<int> xruns_{ 0 };
+};
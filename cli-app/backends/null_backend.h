@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "../audio_backend.h"
+#include "../wav.h"
+
+// =====================
+// NULL / FILE SINK
+// =====================
+// No device: a thread renders one period every period length of wall
+// clock, so the synth plays (silently) in real time. The file sink also
+// streams the output to a 16-bit WAV (`device` is the path), which makes
+// the whole live path testable without audio hardware.
+class NullBackend : public AudioBackend {
+public:
+    ~NullBackend() override { stop(); }
+
+    const char* name() const override { return "null"; }
+
+    bool open(const AudioConfig& config, RenderFn render) override {
+        config_ = config;
+        render_ = render;
+        period_.assign(config.periodFrames, 0.0f);
+        return true;
+    }
+
+    bool start() override {
+        running_ = true;
+        thread_ = std::thread([this] { run(); });
+        return true;
+    }
+
+    void stop() override {
+        if (!running_) return;
+        running_ = false;
+        thread_.join();
+        finish();
+    }
+
+    // nothing is queued: a period is "heard" as soon as it is rendered
+    AudioLatency latency() const override {
+        AudioLatency l;
+        l.periodFrames = config_.periodFrames;
+        l.periods = 1;
+        l.bufferMs = 1000.0 * config_.periodFrames / config_.sampleRate;
+        return l;
+    }
+
+    int xruns() const override { return late_; }
+
+protected:
+    virtual void consume(const float*, int) {}
+    virtual void finish() {}
+
+    AudioConfig config_;
+
+private:
+    void run() {
+        using clock = std::chrono::steady_clock;
+        auto period = std::chrono::duration_cast<clock::duration>(
+            std::chrono::duration<double>(
+                double(config_.periodFrames) / config_.sampleRate));
+        auto next = clock::now();
+
+        while (running_) {
+            render_(period_.data(), config_.periodFrames);
+            consume(period_.data(), config_.periodFrames);
+
+            next += period;
+            if (clock::now() > next) {
+                late_++;
+                next = clock::now();
+            }
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    RenderFn render_ = nullptr;
+    std::vector<float> period_;
+    std::thread thread_;
+    std::atomic<bool> running_{ false };
+    std::atomic<int> late_{ 0 };
+};
+
+class FileBackend : public NullBackend {
+public:
+    ~FileBackend() override { stop(); }
+
+    const char* name() const override { return "file"; }
+
+    bool open(const AudioConfig& config, RenderFn render) override {
+        std::string path = config.device.empty() ? "synth-out.wav"
+                                                 : config.device;
+        if (!wav_.open(path.c_str(), config.sampleRate)) {
+            error_ = "cannot write " + path;
+            return false;
+        }
+        return NullBackend::open(config, render);
+    }
+
+protected:
+    // header refreshed once a second so a killed synth leaves a
+    // playable file
+    void consume(const float* samples, int n) override {
+        wav_.write(samples, n);
+        sinceUpdate_ += n;
+        if (sinceUpdate_ >= config_.sampleRate) {
+            wav_.updateHeader();
+            sinceUpdate_ = 0;
+        }
+    }
+
+    void finish() override { wav_.close(); }
+
+private:
+    WavWriter wav_;
+    int sinceUpdate_ = 0;
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <portaudio.h>
+
+#include "../audio_backend.h"
+
+// =====================
+// PORTAUDIO
+// =====================
+// The original output path: default device, one float channel. The
+// period is the callback size; PortAudio picks its own buffering, so
+// `periods` is not honoured.
+class PortAudioBackend : public AudioBackend {
+public:
+    ~PortAudioBackend() override {
+        stop();
+        if (stream_) Pa_CloseStream(stream_);
+        if (initialized_) Pa_Terminate();
+    }
+
+    const char* name() const override { return "portaudio"; }
+
+    bool open(const AudioConfig& config, RenderFn render) override {
+        config_ = config;
+        render_ = render;
+
+        PaError err = Pa_Initialize();
+        if (err != paNoError) return fail(err);
+        initialized_ = true;
+
+        err = Pa_OpenDefaultStream(
+            &stream_,
+            0,
+            1,
+            paFloat32,
+            config.sampleRate,
+            config.periodFrames,
+            callback,
+            this
+        );
+        if (err != paNoError) return fail(err);
+        return true;
+    }
+
+    bool start() override {
+        PaError err = Pa_StartStream(stream_);
+        if (err != paNoError) return fail(err);
+        running_ = true;
+        return true;
+    }
+
+    void stop() override {
+        if (running_) Pa_StopStream(stream_);
+        running_ = false;
+    }
+
+    AudioLatency latency() const override {
+        AudioLatency l;
+        l.periodFrames = config_.periodFrames;
+        l.periods = 1;
+        l.bufferMs = 1000.0 * config_.periodFrames / config_.sampleRate;
+        if (const PaStreamInfo* info = stream_ ? Pa_GetStreamInfo(stream_) : nullptr) {
+            l.outputMs = 1000.0 * info->outputLatency;
+            l.reported = true;
+        }
+        return l;
+    }
+
+private:
+    static int callback(const void*, void* output, unsigned long frames,
+                        const PaStreamCallbackTimeInfo*,
+                        PaStreamCallbackFlags, void* user) {
+        PortAudioBackend* self = (PortAudioBackend*)user;
+        self->render_((float*)output, int(frames));
+        return paContinue;
+    }
+
+    bool fail(PaError err) {
+        error_ = Pa_GetErrorText(err);
+        return false;
+    }
+
+    AudioConfig config_;
+    RenderFn render_ = nullptr;
+    PaStream* stream_ = nullptr;
+    bool initialized_ = false;
+    bool running_ = false;
+};
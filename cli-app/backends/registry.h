@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstring>
+
+#include "../audio_backend.h"
+#include "null_backend.h"
+#ifndef CYNTH_NO_PORTAUDIO
+#include "portaudio_backend.h"
+#endif
+
+#ifdef CYNTH_ALSA
+#include "alsa_backend.h"
+#endif
+
+#ifdef CYNTH_JACK
+#include "jack_backend.h"
+#endif
+
+// =====================
+// REGISTERED BACKENDS
+// =====================
+// The first one is the default. ALSA needs -DCYNTH_ALSA -lasound, JACK
+// -DCYNTH_JACK -ljack; -DCYNTH_NO_PORTAUDIO builds without PortAudio.
+// CMake sets all three from what it finds.
+inline const BackendInfo BACKENDS[] = {
+#ifndef CYNTH_NO_PORTAUDIO
+    { "portaudio", "PortAudio default output",                  makeBackend<PortAudioBackend> },
+#endif
+#ifdef CYNTH_ALSA
+    { "alsa",      "ALSA mmap, --device PCM (hw:Dummy, null)", makeBackend<AlsaBackend> },
+#endif
+#ifdef CYNTH_JACK
+    { "jack",      "JACK client, --device client name",        makeBackend<JackBackend> },
+#endif
+    { "null",      "no output, real-time paced",               makeBackend<NullBackend> },
+    { "file",      "16-bit WAV, --device path",                makeBackend<FileBackend> },
+};
+
+inline const BackendInfo* findBackend(const char* name) {
+    for (const BackendInfo& info : BACKENDS)
+        if (strcmp(info.name, name) == 0)
+            return &info;
+    return nullptr;
+}
@@ -0,0 +1,1141 @@
+// Offline benchmarks for the engine.
+//
+//   cmake --build build --target bench   (see CMakeLists.txt), or
+//   g++ -O2 -std=c++20 -pthread bench.cpp dsp.cpp -o bench
+//   ./bench            run everything
+//   ./bench mixer      run one benchmark (mixer, compress, layers, bass,
+//                      piano, kick, rt, mod, analysis, osc, jobs,
+//                      resample, choke)
+//
+// Hardware counters need perf_event_open; if it is unavailable (macOS,
+// containers, kernel.perf_event_paranoid > 2) only timings are printed.
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <atomic>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include "analysis.h"
+#include "dsp.h"
+#include "osc.h"
+#include "voices.h"
+#include "perf_counters.h"
+#include "piano_bank.h"
+#include "resampler.h"
+#include "rt.h"
+#include "scheduler.h"
+#include "instruments/registry.h"
+
+constexpr int BENCH_BLOCK  = 256;
+constexpr int BENCH_BLOCKS = 4000;
+
+// =====================
+// SHARED BUFFERS
+// =====================
+float snare[SNARE_N];
+float kick[KICK_N];
+float hihat[HAT_N];
+float openHihat[OPEN_HAT_N];
+float piano[MAX_PIANO_NOTES][PIANO_N];
+
+// the same sounds wrapped for the voice bank
+SampleBuffer snareSample, kickSample, hatSample, openHatSample;
+SampleBuffer pianoSample[MAX_PIANO_NOTES];
+
+void wrap(SampleBuffer& s, const float* src, int n, SampleFormat fmt) {
+    s.allocate(fmt, n);
+    s.encode(src);
+}
+
+void renderBuffers() {
+    generateSnare(snare);
+    generateKick(kick);
+    generateHiHat(hihat);
+    generateOpenHiHat(openHihat);
+    for (int i = 0; i < MAX_PIANO_NOTES; i++)
+        generatePianoNote(piano[i], pianoFreqs[i], false);
+
+    wrap(snareSample, snare, SNARE_N, SampleFormat::Float32);
+    wrap(kickSample, kick, KICK_N, SampleFormat::Float32);
+    wrap(hatSample, hihat, HAT_N, SampleFormat::Float32);
+    wrap(openHatSample, openHihat, OPEN_HAT_N, SampleFormat::Float32);
+    for (int i = 0; i < MAX_PIANO_NOTES; i++)
+        wrap(pianoSample[i], piano[i], PIANO_N, SampleFormat::Float32);
+}
+
+// =====================
+// REPORTING
+// =====================
+struct Result {
+    double nsPerBlock;
+    PerfCounters counters;
+};
+
+void printHeader() {
+    std::cout << std::left << std::setw(22) << "case"
+              << std::right << std::setw(12) << "ns/block"
+              << std::setw(14) << "cycles/blk"
+              << std::setw(14) << "cache-miss"
+              << std::setw(14) << "cache-ref"
+              << std::setw(14) << "L1D-miss"
+              << "\n";
+}
+
+void printRow(const char* name, const Result& r, int blocks) {
+    std::cout << std::left << std::setw(22) << name
+              << std::right << std::fixed << std::setprecision(0)
+              << std::setw(12) << r.nsPerBlock;
+
+    if (r.counters.available()) {
+        const int cols[] = {
+            PerfCounters::CYCLES, PerfCounters::CACHE_MISSES,
+            PerfCounters::CACHE_REFS, PerfCounters::L1D_MISSES
+        };
+        std::cout << std::setprecision(1);
+        for (int c : cols)
+            std::cout << std::setw(14) << double(r.counters.value[c]) / blocks;
+    } else {
+        std::cout << std::setw(14) << "-" << std::setw(14) << "-"
+                  << std::setw(14) << "-" << std::setw(14) << "-";
+    }
+    std::cout << "\n";
+}
+
+template <typename Fn>
+Result measure(Fn&& runBlock, int blocks) {
+    Result r;
+    r.counters.open();
+
+    auto t0 = std::chrono::steady_clock::now();
+    r.counters.start();
+    for (int b = 0; b < blocks; b++)
+        runBlock(b);
+    r.counters.stop();
+    auto t1 = std::chrono::steady_clock::now();
+    r.counters.close();
+
+    r.nsPerBlock =
+        std::chrono::duration<double, std::nano>(t1 - t0).count() / blocks;
+    return r;
+}
+
+// A fixed pattern that keeps drums and a rolling piano chord going:
+// kick on 1, snare on 3, hats on every quarter, a new piano key every
+// other block (notes ring for ~430 blocks, so most keys overlap).
+enum Hit { HIT_KICK = -1, HIT_SNARE = -2, HIT_HAT = -3 };  // >= 0: piano key
+
+template <typename Fn>
+void forEachHit(int block, Fn&& hit) {
+    if (block % 16 == 0) hit(HIT_KICK);
+    if (block % 16 == 8) hit(HIT_SNARE);
+    if (block % 4 == 0)  hit(HIT_HAT);
+    if (block % 2 == 0)  hit((block / 2) % MAX_PIANO_NOTES);
+}
+
+// =====================
+// MIXER: per-sound atomic playheads (previous layout)
+// =====================
+namespace legacy {
+
+std::atomic<int> snarePH(-1);
+std::atomic<int> kickPH(-1);
+std::atomic<int> hatPH(-1);
+std::atomic<int> pianoPH[MAX_PIANO_NOTES];
+
+void mix(float* out, int frameCount) {
+    for (int i = 0; i < frameCount; i++) {
+        float mix = 0.0f;
+        int p;
+
+        p = snarePH.load();
+        if (p >= 0 && p < SNARE_N) {
+            mix += snare[p];
+            snarePH.fetch_add(1);
+        }
+
+        p = kickPH.load();
+        if (p >= 0 && p < KICK_N) {
+            mix += kick[p];
+            kickPH.fetch_add(1);
+        }
+
+        p = hatPH.load();
+        if (p >= 0 && p < HAT_N) {
+            mix += hihat[p];
+            hatPH.fetch_add(1);
+        }
+
+        for (int n = 0; n < MAX_PIANO_NOTES; n++) {
+            int p = pianoPH[n].load();
+            if (p >= 0 && p < PIANO_N) {
+                mix += piano[n][p];
+                pianoPH[n].fetch_add(1);
+            }
+        }
+
+        out[i] = tanh(mix * 0.8f);
+    }
+}
+
+} // namespace legacy
+
+void benchMixer() {
+    std::cout << "\n== mixer: " << BENCH_BLOCKS << " blocks of "
+              << BENCH_BLOCK << " frames ==\n";
+
+    float out[BENCH_BLOCK];
+
+    for (auto& ph : legacy::pianoPH) ph = -1;
+
+    Result before = measure([&](int b) {
+        forEachHit(b, [](int what) {
+            if (what == HIT_KICK) legacy::kickPH = 0;
+            else if (what == HIT_SNARE) legacy::snarePH = 0;
+            else if (what == HIT_HAT) legacy::hatPH = 0;
+            else legacy::pianoPH[what] = 0;
+        });
+        legacy::mix(out, BENCH_BLOCK);
+    }, BENCH_BLOCKS);
+
+    VoiceBank voices;
+    TriggerQueue triggers;
+
+    Result after = measure([&](int b) {
+        forEachHit(b, [&](int what) {
+            if (what == HIT_KICK) triggers.push({ &kickSample, 1.0f, 1 });
+            else if (what == HIT_SNARE) triggers.push({ &snareSample, 1.0f, 0 });
+            else if (what == HIT_HAT) triggers.push({ &hatSample, 1.0f, 2 });
+            else triggers.push({ &pianoSample[what], 1.0f, 3 + what });
+        });
+
+        Trigger t;
+        while (triggers.pop(t))
+            startVoice(voices, t);
+
+        float mix[BENCH_BLOCK] = {};
+        mixVoices(voices, mix, BENCH_BLOCK);
+        for (int i = 0; i < BENCH_BLOCK; i++)
+            out[i] = tanh(mix[i] * 0.8f);
+    }, BENCH_BLOCKS);
+
+    printHeader();
+    printRow("atomic playheads", before, BENCH_BLOCKS);
+    printRow("SoA voice bank", after, BENCH_BLOCKS);
+
+    if (!before.counters.available())
+        std::cout << "(perf counters unavailable)\n";
+}
+
+// =====================
+// COMPRESSED PIANO BANK
+// =====================
+// Memory, reconstruction error and mixing cost of the piano bank in
+// each storage format. Error is measured against the float render over
+// all 20 notes; SNR is signal power over error power.
+void benchCompress() {
+    std::cout << "\n== compress: piano bank, " << MAX_PIANO_NOTES
+              << " notes x " << PIANO_N << " samples ==\n";
+
+    std::cout << std::left << std::setw(8) << "format"
+              << std::right << std::setw(12) << "KiB"
+              << std::setw(10) << "ratio"
+              << std::setw(12) << "SNR dB"
+              << std::setw(12) << "max err"
+              << std::setw(12) << "ns/block"
+              << "\n";
+
+    const SampleFormat formats[] = {
+        SampleFormat::Float32, SampleFormat::Int16, SampleFormat::BlockFloat8
+    };
+
+    size_t floatBytes = 0;
+
+    for (SampleFormat fmt : formats) {
+        static SampleBuffer bank[MAX_PIANO_NOTES];
+        size_t bytes = 0;
+        double signal = 0.0, noise = 0.0, maxErr = 0.0;
+
+        for (int n = 0; n < MAX_PIANO_NOTES; n++) {
+            wrap(bank[n], piano[n], PIANO_N, fmt);
+            bytes += bank[n].bytes();
+
+            for (int i = 0; i < PIANO_N; i++) {
+                double ref = piano[n][i];
+                double err = bank[n].at(i) - ref;
+                signal += ref * ref;
+                noise += err * err;
+                maxErr = std::max(maxErr, std::fabs(err));
+            }
+        }
+        if (fmt == SampleFormat::Float32) floatBytes = bytes;
+
+        // all 20 notes ringing at once, restarted when they run out
+        VoiceBank voices;
+        float mix[BENCH_BLOCK];
+        Result r = measure([&](int) {
+            if (voices.active == 0)
+                for (int n = 0; n < MAX_PIANO_NOTES; n++)
+                    startVoice(voices, { &bank[n], 1.0f, n });
+            std::fill(mix, mix + BENCH_BLOCK, 0.0f);
+            mixVoices(voices, mix, BENCH_BLOCK);
+        }, BENCH_BLOCKS);
+
+        std::cout << std::left << std::setw(8) << formatName(fmt)
+                  << std::right << std::fixed
+                  << std::setw(12) << std::setprecision(0) << bytes / 1024.0
+                  << std::setw(10) << std::setprecision(2)
+                  << double(floatBytes) / bytes
+                  << std::setw(12) << std::setprecision(1);
+        if (noise > 0.0)
+            std::cout << 10.0 * log10(signal / noise);
+        else
+            std::cout << "inf";
+        std::cout << std::setw(12) << std::scientific << std::setprecision(2)
+                  << maxErr << std::fixed
+                  << std::setw(12) << std::setprecision(0) << r.nsPerBlock
+                  << "\n";
+    }
+}
+
+// =====================
+// VELOCITY LAYERS
+// =====================
+// Build time and memory of the piano bank per layer count.
+void benchLayers() {
+    std::cout << "\n== layers: piano bank build, "
+              << std::thread::hardware_concurrency() << " thread(s) ==\n";
+
+    std::cout << std::left << std::setw(8) << "layers"
+              << std::right << std::setw(8) << "format"
+              << std::setw(12) << "KiB"
+              << std::setw(12) << "build ms"
+              << "\n";
+
+    for (SampleFormat fmt : { SampleFormat::Float32, SampleFormat::Int16 }) {
+        for (int layers : { 1, 2, 4 }) {
+            PianoBank bank;
+            bank.allocate(fmt, layers, 1);
+
+            auto t0 = std::chrono::steady_clock::now();
+            bank.render(1.0);
+            auto t1 = std::chrono::steady_clock::now();
+
+            std::cout << std::left << std::setw(8) << layers
+                      << std::right << std::setw(8) << formatName(fmt)
+                      << std::setw(12) << bank.bytes() / 1024
+                      << std::setw(12) << std::fixed << std::setprecision(0)
+                      << std::chrono::duration<double, std::milli>(t1 - t0).count()
+                      << "\n";
+        }
+    }
+}
+
+// =====================
+// LIVE BASS
+// =====================
+// Per-voice block cost of bass-v1 (per-sample sin/exp) and bass
+// (recurrences) at 1..8 voices against BASS_BUDGET_US, then a full
+// block of drums + piano voices + 4 bass voices against the block period.
+void benchBass() {
+    const double periodUs = 1e6 * BENCH_BLOCK / SAMPLE_RATE;
+
+    std::cout << "\n== bass: " << BENCH_BLOCK << "-frame blocks ("
+              << std::fixed << std::setprecision(0) << periodUs
+              << " us), budget " << BASS_BUDGET_US << " us/voice ==\n";
+
+    std::cout << std::left << std::setw(10) << "instr"
+              << std::right << std::setw(8) << "voices"
+              << std::setw(12) << "us/block"
+              << std::setw(12) << "us/voice"
+              << std::setw(10) << "budget"
+              << "\n";
+
+    for (const char* name : { "bass-v1", "bass" }) {
+        for (int voices : { 1, 4, 8 }) {
+            auto inst = findInstrument(name)->create();
+            inst->prepare(SAMPLE_RATE, BENCH_BLOCK);
+
+            float out[BENCH_BLOCK];
+            const int blocks = 400;  // ~2.3 s, the whole note
+
+            Result r = measure([&](int b) {
+                if (b == 0)
+                    for (int v = 0; v < voices; v++)
+                        inst->noteOn(28 + 5 * v, 1.0f);
+                std::fill(out, out + BENCH_BLOCK, 0.0f);
+                inst->renderBlock(out, BENCH_BLOCK);
+            }, blocks);
+
+            double us = r.nsPerBlock / 1000.0;
+            std::cout << std::left << std::setw(10) << name
+                      << std::right << std::setw(8) << voices
+                      << std::setw(12) << std::setprecision(1) << us
+                      << std::setw(12) << us / voices
+                      << std::setw(10)
+                      << (us / voices <= BASS_BUDGET_US ? "ok" : "OVER")
+                      << "\n";
+        }
+    }
+
+    Bass bass;
+    bass.prepare(SAMPLE_RATE, BENCH_BLOCK);
+    VoiceBank voices;
+    float out[BENCH_BLOCK];
+
+    Result r = measure([&](int b) {
+        forEachHit(b, [&](int what) {
+            if (what == HIT_KICK) startVoice(voices, { &kickSample, 1.0f, 1 });
+            else if (what == HIT_SNARE) startVoice(voices, { &snareSample, 1.0f, 0 });
+            else if (what == HIT_HAT) startVoice(voices, { &hatSample, 1.0f, 2 });
+            else startVoice(voices, { &pianoSample[what], 1.0f, 3 + what });
+        });
+        if (b % 64 == 0)
+            for (int v = 0; v < 4; v++)
+                bass.noteOn(28 + 7 * v, 1.0f);
+
+        float mix[BENCH_BLOCK] = {};
+        mixVoices(voices, mix, BENCH_BLOCK);
+        bass.renderBlock(mix, BENCH_BLOCK);
+        for (int i = 0; i < BENCH_BLOCK; i++)
+            out[i] = tanh(mix[i] * 0.8f);
+    }, BENCH_BLOCKS);
+
+    std::cout << "drums + piano + 4 bass voices: " << std::setprecision(1)
+              << r.nsPerBlock / 1000.0 << " us/block ("
+              << 100.0 * r.nsPerBlock / 1000.0 / periodUs
+              << "% of the block period)\n";
+}
+
+// =====================
+// PIANO STRING MODELS
+// =====================
+// Cost of one 2.5 s note, additive vs waveguide strings, across pitch
+// and velocity (which set the harmonic count of the additive model).
+void benchPiano() {
+    std::cout << "\n== piano: one " << PIANO_DUR << " s note ==\n";
+
+    std::cout << std::left << std::setw(10) << "freq"
+              << std::right << std::setw(10) << "velocity"
+              << std::setw(14) << "additive ms"
+              << std::setw(14) << "waveguide ms"
+              << std::setw(10) << "speedup"
+              << "\n";
+
+    static float out[PIANO_N];
+
+    for (double freq : { 65.41, 261.63, 783.99 }) {
+        for (double velocity : { 0.3, 1.0 }) {
+            double ms[2];
+            const PianoModel models[2] = {
+                PianoModel::Additive, PianoModel::Waveguide
+            };
+
+            for (int m = 0; m < 2; m++) {
+                auto t0 = std::chrono::steady_clock::now();
+                generatePianoNote(out, freq, false, velocity, 0, models[m]);
+                auto t1 = std::chrono::steady_clock::now();
+                ms[m] =
+                    std::chrono::duration<double, std::milli>(t1 - t0).count();
+            }
+
+            std::cout << std::fixed << std::setprecision(1)
+                      << std::left << std::setw(10) << freq
+                      << std::right << std::setw(10) << velocity
+                      << std::setw(14) << ms[0]
+                      << std::setw(14) << ms[1]
+                      << std::setw(9) << ms[0] / ms[1] << "x"
+                      << "\n";
+        }
+    }
+}
+
+// =====================
+// LIVE KICK
+// =====================
+// 32 overlapping kicks, each with its own pitch and decays, rendered
+// for 0.5 s: table-driven KickVoice against KickFixedVoice, which calls
+// sin/exp per sample (plus the tanh generateKick applies).
+void benchKick() {
+    const int hits = 32;
+    const int blocks = KICK_N / BENCH_BLOCK;
+
+    std::cout << "\n== kick: " << hits
+              << " overlapping hits, varied pitch/decay ==\n";
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+
+    static KickVoice table[hits];
+    static KickFixedVoice reference[hits];
+    for (int h = 0; h < hits; h++) {
+        int note = 30 + int(u(rng) * 12);
+        table[h].params.ampDecay = 4.0 + u(rng) * 8.0;
+        table[h].params.pitchDecay = 10.0 + u(rng) * 30.0;
+        table[h].start(note, 0.5f, SAMPLE_RATE);
+        reference[h].start(note, 0.5f, SAMPLE_RATE);
+    }
+
+    float out[BENCH_BLOCK];
+
+    Result tables = measure([&](int) {
+        std::fill(out, out + BENCH_BLOCK, 0.0f);
+        for (KickVoice& v : table)
+            v.render(out, BENCH_BLOCK);
+    }, blocks);
+
+    Result libm = measure([&](int) {
+        float tmp[BENCH_BLOCK];
+        std::fill(out, out + BENCH_BLOCK, 0.0f);
+        for (KickFixedVoice& v : reference) {
+            std::fill(tmp, tmp + BENCH_BLOCK, 0.0f);
+            v.render(tmp, BENCH_BLOCK);
+            for (int i = 0; i < BENCH_BLOCK; i++)
+                out[i] += tanh(tmp[i] * 1.2f);
+        }
+    }, blocks);
+
+    const double perVoiceSample = 1.0 / (hits * BENCH_BLOCK);
+    std::cout << std::fixed << std::setprecision(2)
+              << "kick (tables)       " << std::setw(8)
+              << tables.nsPerBlock * perVoiceSample << " ns/voice-sample, "
+              << std::setprecision(1) << tables.nsPerBlock / 1000.0
+              << " us/block\n"
+              << std::setprecision(2)
+              << "kick-fixed + tanh   " << std::setw(8)
+              << libm.nsPerBlock * perVoiceSample << " ns/voice-sample, "
+              << std::setprecision(1) << libm.nsPerBlock / 1000.0
+              << " us/block\n";
+}
+
+// =====================
+// DENORMALS
+// =====================
+// A body of 16 soundboard resonators (the piano's four, at 1-4x)
+// ringing out after one strike, in callback-sized blocks timed one at
+// a time like the synth's callback histogram. After ~3 s the tails are
+// denormal; once without and once with the FTZ/DAZ scope the synth
+// callback applies.
+void benchRt() {
+    const int blocks = 12 * SAMPLE_RATE / BENCH_BLOCK;
+    const double budgetUs = 1e6 * BENCH_BLOCK / SAMPLE_RATE;
+    const double freqs[4]  = { 90.0, 180.0, 420.0, 900.0 };
+    const double decays[4] = { 0.0015, 0.0025, 0.0035, 0.005 };
+
+    std::cout << "\n== rt: 16 resonators ringing out, " << BENCH_BLOCK
+              << "-frame blocks over 12 s ==\n";
+
+    auto run = [&](bool flush) {
+        NoDenormals scope(flush);
+
+        Resonator body[16];
+        for (int r = 0; r < 16; r++)
+            body[r].setup(freqs[r % 4] * (1 + r / 4), decays[r % 4]);
+
+        float out[BENCH_BLOCK];
+        double strike = 1.0;
+
+        static TimingHistogram h;
+        h.reset();
+        double totalUs = 0.0;
+        for (int b = 0; b < blocks; b++) {
+            auto t0 = std::chrono::steady_clock::now();
+            for (int i = 0; i < BENCH_BLOCK; i++) {
+                double s = 0.0;
+                for (Resonator& r : body)
+                    s += r.process(strike);
+                strike = 0.0;
+                out[i] = (float)s;
+            }
+            auto t1 = std::chrono::steady_clock::now();
+
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                t1 - t0).count();
+            h.record(uint64_t(ns), uint64_t(budgetUs * 1000.0));
+            totalUs += ns / 1000.0;
+        }
+
+        std::cout << (flush ? "FTZ/DAZ on" : "FTZ/DAZ off") << ": "
+                  << std::fixed << std::setprecision(1)
+                  << totalUs / blocks << " us/block mean (out "
+                  << out[BENCH_BLOCK - 1] << ")\n";
+        h.print(std::cout, budgetUs);
+    };
+
+    run(false);
+    run(true);
+}
+
+// =====================
+// CONTROL-RATE MODULATION
+// =====================
+// 8 pad voices (filter ADSR + LFO, vibrato, amp ADSR) for 2 s with the
+// modulators, filter coefficients and pitch evaluated per sample
+// against once per CONTROL_BLOCK, and how far apart the two come out.
+void benchMod() {
+    const int voices = 8;
+    const int blocks = 2 * SAMPLE_RATE / BENCH_BLOCK;
+
+    std::cout << "\n== mod: " << voices << " pad voices, control every "
+              << CONTROL_BLOCK << " samples vs every sample ==\n";
+
+    PadParams params;
+    params.cutoff.reset(600.0f);
+    params.vibrato.reset(0.12f);
+
+    static PadVoiceT<1> perSample[voices];
+    static PadVoiceT<CONTROL_BLOCK> perBlock[voices];
+    for (int v = 0; v < voices; v++) {
+        perSample[v].params = &params;
+        perBlock[v].params = &params;
+        perSample[v].start(48 + 3 * v, 0.8f, SAMPLE_RATE);
+        perBlock[v].start(48 + 3 * v, 0.8f, SAMPLE_RATE);
+    }
+
+    std::vector<float> a(blocks * BENCH_BLOCK, 0.0f);
+    std::vector<float> b(blocks * BENCH_BLOCK, 0.0f);
+
+    Result sample = measure([&](int blk) {
+        for (auto& v : perSample)
+            v.render(a.data() + blk * BENCH_BLOCK, BENCH_BLOCK);
+    }, blocks);
+
+    Result block = measure([&](int blk) {
+        for (auto& v : perBlock)
+            v.render(b.data() + blk * BENCH_BLOCK, BENCH_BLOCK);
+    }, blocks);
+
+    double diff = 0.0, peak = 0.0;
+    for (size_t i = 0; i < a.size(); i++) {
+        diff = std::max(diff, double(fabsf(a[i] - b[i])));
+        peak = std::max(peak, double(fabsf(a[i])));
+    }
+
+    const double perVoiceSample = 1.0 / (voices * BENCH_BLOCK);
+    std::cout << std::fixed << std::setprecision(2)
+              << "control per sample  " << std::setw(8)
+              << sample.nsPerBlock * perVoiceSample << " ns/voice-sample\n"
+              << "control per " << std::setw(2) << CONTROL_BLOCK
+              << "      " << std::setw(8)
+              << block.nsPerBlock * perVoiceSample << " ns/voice-sample ("
+              << sample.nsPerBlock / block.nsPerBlock << "x)\n"
+              << std::setprecision(1) << "max difference "
+              << 20.0 * log10(diff / peak) << " dB below peak\n";
+}
+
+// =====================
+// ANALYSIS TAP
+// =====================
+// What the analyzer costs the audio thread (a ring copy per block) and
+// its worker (one windowed STFT frame and band sum per hop), against
+// the block period and the hop period.
+void benchAnalysis() {
+    const double blockUs = 1e6 * BENCH_BLOCK / SAMPLE_RATE;
+    AnalyzerConfig config;
+
+    std::cout << "\n== analysis: tap on " << BENCH_BLOCK << "-frame blocks, "
+              << config.fftSize << "-point STFT every " << config.hop
+              << " ==\n";
+
+    std::string error;
+    Analyzer analyzer;
+    analyzer.start(openAnalysisSink("/dev/null", error), SAMPLE_RATE, config);
+
+    // real time, so the worker keeps up as it would live
+    const int blocks = 2 * SAMPLE_RATE / BENCH_BLOCK;
+    const SampleBuffer& src = pianoSample[10];
+    double pushNs = 0.0, worstNs = 0.0;
+    for (int b = 0; b < blocks; b++) {
+        const float* block = src.f32.data() + (b * BENCH_BLOCK) % (PIANO_N - BENCH_BLOCK);
+        auto t0 = std::chrono::steady_clock::now();
+        analyzer.push(block, BENCH_BLOCK);
+        auto t1 = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        pushNs += ns;
+        worstNs = std::max(worstNs, ns);
+        std::this_thread::sleep_for(std::chrono::microseconds(int(blockUs)));
+    }
+    analyzer.stop();
+
+    Fft fft(config.fftSize);
+    std::vector<float> frame(src.f32.begin(), src.f32.begin() + config.fftSize);
+    std::vector<float> power(config.fftSize / 2 + 1);
+    const int frames = 2000;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) {
+        frame[f % config.fftSize] += 1e-6f;
+        fft.power(frame.data(), power.data());
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    double fftUs = std::chrono::duration<double, std::micro>(t1 - t0).count() / frames;
+    double hopUs = 1e6 * config.hop / SAMPLE_RATE;
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "audio thread: push " << pushNs / blocks << " ns/block mean, "
+              << worstNs << " ns worst (" << std::setprecision(3)
+              << 100.0 * pushNs / blocks / (blockUs * 1000.0)
+              << "% of the block period)\n" << std::setprecision(1)
+              << "worker: FFT " << fftUs << " us/frame, " << std::setprecision(2)
+              << 100.0 * fftUs / hopUs << "% of one core at one frame per "
+              << config.hop << " samples; " << analyzer.frames()
+              << " frames written, " << analyzer.dropped() << " samples dropped\n";
+}
+
+// =====================
+// OSC
+// =====================
+// Networked control over loopback. Parsing alone, then a sender blasting
+// bundles at an OscListener with a consumer draining its queue (events
+// per second end to end, and what was lost), then one snare per ~23 ms
+// against an audio loop paced at real time: how long a packet waits from
+// arrival until the block it sounds in has been rendered. A device adds
+// its output buffer on top of that.
+void benchOsc() {
+    std::cout << "\n== osc: loopback UDP, 8-message bundles ==\n";
+
+    // a bundle of 8 /piano messages, built once
+    uint8_t bundle[512];
+    memcpy(bundle, "#bundle\0\0\0\0\0\0\0\0\1", 16);
+    size_t size = 16;
+    for (int m = 0; m < 8; m++) {
+        size_t n = oscWrite(bundle + size + 4, sizeof(bundle) - size - 4,
+                            "/piano", "if", m, 0.5f + 0.05f * m);
+        bundle[size] = bundle[size + 1] = bundle[size + 2] = 0;
+        bundle[size + 3] = uint8_t(n);
+        size += 4 + n;
+    }
+
+    const int parses = 200000;
+    uint64_t parsed = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < parses; i++)
+        parseOsc(bundle, size, [&](const OscMessage& m) {
+            OscEvent e;
+            parsed += oscToEvent(m, e);
+        });
+    auto t1 = std::chrono::steady_clock::now();
+    double parseS = std::chrono::duration<double>(t1 - t0).count();
+    std::cout << std::fixed << std::setprecision(1)
+              << "parse:    " << 8.0 * parses / parseS / 1e6
+              << " M events/s (" << 1e9 * parseS / (8.0 * parses)
+              << " ns/event, " << parsed << " understood)\n";
+
+    std::string error;
+    auto sendSocket = [](int port) {
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in to = {};
+        to.sin_family = AF_INET;
+        to.sin_port = htons(uint16_t(port));
+        to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        connect(fd, (sockaddr*)&to, sizeof(to));
+        return fd;
+    };
+
+    // throughput: the consumer stands in for the audio thread
+    {
+        auto queue = std::make_unique<OscQueue>();
+        OscListener listener;
+        if (!listener.open("127.0.0.1:0", error)) {
+            std::cout << error << "\n";
+            return;
+        }
+        listener.start(*queue);
+
+        std::atomic<bool> done(false);
+        uint64_t consumed = 0;
+        std::thread consumer([&]() {
+            OscEvent e;
+            while (!done) {
+                while (queue->pop(e)) consumed++;
+                std::this_thread::yield();
+            }
+            while (queue->pop(e)) consumed++;
+        });
+
+        int fd = sendSocket(listener.port());
+        const int packets = 100000;
+        t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < packets; i++) {
+            send(fd, bundle, size, 0);
+            if (i % 64 == 63) std::this_thread::yield();
+        }
+        // until the listener has seen everything that arrived
+        uint64_t seen = 0;
+        while (listener.packets() != seen || seen == 0) {
+            seen = listener.packets();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        t1 = std::chrono::steady_clock::now();
+        done = true;
+        consumer.join();
+        listener.stop();
+        ::close(fd);
+
+        double s = std::chrono::duration<double>(t1 - t0).count() - 0.02;
+        std::cout << "loopback: " << listener.events() / s / 1e6
+                  << " M events/s end to end; " << packets << " packets sent, "
+                  << listener.packets() << " received, " << listener.dropped()
+                  << " events dropped at the queue, " << consumed
+                  << " consumed\n";
+    }
+
+    // latency: arrival -> rendered, against a real-time block clock
+    {
+        auto queue = std::make_unique<OscQueue>();
+        OscListener listener;
+        if (!listener.open("127.0.0.1:0", error)) return;
+        listener.start(*queue);
+        int fd = sendSocket(listener.port());
+
+        uint8_t hit[64];
+        size_t hitSize = oscWrite(hit, sizeof(hit), "/drum/snare", "f", 1.0f);
+        const int hits = 200;
+        std::atomic<bool> sending(true);
+        std::thread sender([&]() {
+            for (int i = 0; i < hits; i++) {
+                std::this_thread::sleep_for(std::chrono::microseconds(23000 + 137 * (i % 7)));
+                send(fd, hit, hitSize, 0);
+            }
+            sending = false;
+        });
+
+        const double blockUs = 1e6 * BENCH_BLOCK / SAMPLE_RATE;
+        VoiceBank voices;
+        TimingHistogram arrivalToSound;
+        auto next = std::chrono::steady_clock::now();
+        for (int tail = 0; tail < 10; tail += !sending) {
+            next += std::chrono::microseconds(int(blockUs));
+            std::this_thread::sleep_until(next);
+
+            int64_t stamps[8];
+            int n = 0;
+            OscEvent e;
+            while (queue->pop(e)) {
+                startVoice(voices, { &snareSample, e.value, 0 });
+                if (n < 8) stamps[n++] = e.timeNs;
+            }
+            float mix[BENCH_BLOCK] = {};
+            mixVoices(voices, mix, BENCH_BLOCK);
+            int64_t rendered = monotonicNs();
+            bool sounding = std::any_of(mix, mix + BENCH_BLOCK,
+                                        [](float x) { return x != 0.0f; });
+            for (int i = 0; i < n && sounding; i++)
+                arrivalToSound.record(uint64_t(rendered - stamps[i]),
+                                      uint64_t(1000 * blockUs));
+        }
+        sender.join();
+        listener.stop();
+        ::close(fd);
+
+        std::cout << "arrival -> rendered, " << BENCH_BLOCK
+                  << "-frame blocks (then + the device's output buffer):\n";
+        arrivalToSound.print(std::cout, blockUs, "hits");
+    }
+}
+
+// =====================
+// BACKGROUND JOBS
+// =====================
+// Warming keeps every Scheduler worker busy: a job per note of a 2x2
+// bank, each rendering a PIANO_CHUNK per yield. Meanwhile a "key" every
+// 25 ms spawns render-ahead for 8 chunks, due 50 ms later. It runs
+// twice, with priorities and deadlines as the piano bank uses them and
+// with everything Normal, first come first served.
+//
+// `deadline` is when the job is due; only Urgent jobs are scheduled by
+// it.
+Job benchChunks(Scheduler& s, int chunks, Priority priority,
+                JobClock::time_point deadline, std::atomic<bool>& stop,
+                std::atomic<int>& live, std::atomic<uint64_t>& done,
+                TimingHistogram* lifetime) {
+    auto spawned = JobClock::now();
+    auto note = std::make_unique<PianoNote>();
+    note->start(pianoFreqs[chunks % MAX_PIANO_NOTES], false);
+    float buffer[PIANO_CHUNK];
+    for (int c = 0; c < chunks && !stop; c++) {
+        note->render(buffer, PIANO_CHUNK);
+        done.fetch_add(1, std::memory_order_relaxed);
+        co_await s.yield(priority,
+                         priority == Priority::Urgent ? deadline : NO_DEADLINE);
+    }
+    if (lifetime) {
+        auto now = JobClock::now();
+        lifetime->record(
+            uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                now - spawned).count()),
+            uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                deadline - spawned).count()));
+    }
+    live -= 1;
+}
+
+void benchJobs() {
+    const auto keyEvery = std::chrono::milliseconds(25);
+    const auto due = std::chrono::milliseconds(50);
+    const int keyChunks = 8;
+    const int keys = 120;
+    const int warmJobs = 2 * 2 * MAX_PIANO_NOTES * 2;
+
+    std::cout << "\n== jobs: render-ahead (" << keyChunks << " chunks due in "
+              << due.count() << " ms, every " << keyEvery.count()
+              << " ms) against " << warmJobs << " warming jobs ==\n";
+
+    for (bool priorities : { false, true }) {
+        Scheduler s;
+        std::atomic<bool> stop(false);
+        std::atomic<int> live(0);
+        std::atomic<uint64_t> warmChunks(0), keyChunksDone(0);
+        TimingHistogram keyTimes;
+
+        Priority warmAt = priorities ? Priority::Background : Priority::Normal;
+        for (int w = 0; w < warmJobs; w++) {
+            live += 1;
+            s.spawn(benchChunks(s, INT32_MAX, warmAt, NO_DEADLINE, stop, live,
+                                warmChunks, nullptr), warmAt);
+        }
+
+        auto t0 = JobClock::now();
+        for (int k = 0; k < keys; k++) {
+            std::this_thread::sleep_until(t0 + k * keyEvery);
+            auto deadline = JobClock::now() + due;
+            Priority keyAt = priorities ? Priority::Urgent : Priority::Normal;
+            live += 1;
+            s.spawn(benchChunks(s, keyChunks, keyAt, deadline, stop, live,
+                                keyChunksDone, &keyTimes),
+                    keyAt, priorities ? deadline : NO_DEADLINE);
+        }
+        while (keyChunksDone < uint64_t(keys * keyChunks))
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        double seconds = std::chrono::duration<double>(JobClock::now() - t0).count();
+        stop = true;
+        while (live > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        std::cout << (priorities ? "urgent over background, EDF"
+                                 : "one queue, first come first served")
+                  << ": " << s.threads() << " worker(s), "
+                  << std::fixed << std::setprecision(0)
+                  << warmChunks / seconds << " warming chunks/s\n"
+                  << "key -> render-ahead done (" << due.count()
+                  << " ms budget):\n";
+        keyTimes.print(std::cout, 1000.0 * due.count(), "keys");
+        if (priorities) s.print(std::cout);
+    }
+}
+
+// =====================
+// RESAMPLER
+// =====================
+// Quality against exact sines: a rate conversion, an octave down and an
+// octave up (SNR over the middle of the output), and what is left of a
+// tone that an octave up puts above Nyquist (it should vanish, not
+// fold back). Then the mixer with the piano chord of `mixer` pitched:
+// the resampler's cost per block against plain voices.
+double sineError(const std::vector<float>& out, double freq, int rate,
+                 double phase0, double& signal) {
+    double err = 0.0;
+    signal = 0.0;
+    size_t from = out.size() / 4, to = out.size() * 3 / 4;
+    for (size_t i = from; i < to; i++) {
+        double want = 0.5 * sin(phase0 + 2.0 * M_PI * freq * double(i) / rate);
+        err += (out[i] - want) * (out[i] - want);
+        signal += want * want;
+    }
+    return err;
+}
+
+void benchResample() {
+    std::cout << "\n== resample: " << 2 * RESAMPLE_HALF << " taps x "
+              << RESAMPLE_PHASES << " phases, Kaiser " << RESAMPLE_BETA
+              << " ==\n";
+
+    auto sine = [](double freq, int rate, int n) {
+        std::vector<float> x(n);
+        for (int i = 0; i < n; i++)
+            x[i] = float(0.5 * sin(2.0 * M_PI * freq * i / rate));
+        return x;
+    };
+
+    struct Case { const char* name; double freq; int from, to; double outFreq; };
+    const Case cases[] = {
+        { "48k -> 44.1k, 1 kHz",   1000.0, 48000, SAMPLE_RATE, 1000.0 },
+        { "48k -> 44.1k, 15 kHz", 15000.0, 48000, SAMPLE_RATE, 15000.0 },
+        { "octave down, 8 kHz",    8000.0, SAMPLE_RATE, 2 * SAMPLE_RATE, 4000.0 },
+        { "octave up, 5 kHz",      5000.0, SAMPLE_RATE, SAMPLE_RATE / 2, 10000.0 },
+        { "octave up, 15 kHz",    15000.0, SAMPLE_RATE, SAMPLE_RATE / 2, 0.0 },
+    };
+    std::cout << std::left << std::setw(26) << "case" << std::right
+              << std::setw(14) << "SNR dB" << std::setw(16) << "ns/out frame" << "\n";
+    for (const Case& c : cases) {
+        std::vector<float> in = sine(c.freq, c.from, SAMPLE_RATE);
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<float> out = resample(in, c.from, c.to);
+        auto t1 = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count()
+                  / out.size();
+
+        // an octave "up" or "down" read at the original rate
+        int rate = c.outFreq == c.freq ? c.to : c.from;
+        double signal, err = sineError(out, c.outFreq, rate, 0.0, signal);
+        if (c.outFreq == 0.0) {  // residue against the input's level
+            signal = 0.125 * out.size() / 2;
+        }
+        std::cout << std::left << std::setw(26) << c.name << std::right
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(14) << 10.0 * log10(signal / std::max(err, 1e-30))
+                  << std::setw(16) << ns << "\n";
+    }
+
+    // the chord from `mixer`, piano only, plain and pitched
+    std::cout << "mixer, rolling piano chord (" << BENCH_BLOCKS << " blocks of "
+              << BENCH_BLOCK << "):\n";
+    preparePitch();
+    for (float step : { 1.0f, 0.5f, 0.25f, 2.0f, 4.0f, 1.5f }) {
+        VoiceBank voices;
+        TriggerQueue triggers;
+        int peak = 0;
+        Result r = measure([&](int b) {
+            forEachHit(b, [&](int what) {
+                if (what >= 0)
+                    triggers.push({ &pianoSample[what], 1.0f, what, nullptr,
+                                    Trigger::Start, step });
+            });
+            Trigger t;
+            while (triggers.pop(t))
+                startVoice(voices, t);
+            float mix[BENCH_BLOCK] = {};
+            mixVoices(voices, mix, BENCH_BLOCK);
+            peak = std::max(peak, voices.active);
+        }, BENCH_BLOCKS);
+        std::cout << "  step " << std::setw(4) << std::setprecision(2) << step
+                  << ": " << std::setprecision(1) << std::setw(7)
+                  << r.nsPerBlock / 1000.0 << " us/block, up to " << peak
+                  << " voices, " << std::setprecision(2)
+                  << 100.0 * r.nsPerBlock / (1e9 * BENCH_BLOCK / SAMPLE_RATE)
+                  << "% of the block period\n";
+    }
+}
+
+// =====================
+// CHOKE GROUPS
+// =====================
+// A closed hat cutting an open one: how fast what is left of the open
+// hat goes (its level over the 64 frames before and after the cut, and
+// frames until silence), and what the fade costs the mixer. Restarting
+// the hat's voice in place stops it dead, a step in the envelope that
+// is heard as a click; the choke ramps it out.
+void benchChoke() {
+    std::cout << "\n== choke: " << CHOKE_FRAMES << "-frame fade ==\n";
+
+    // open hat on block 0, closed hat on block CUT; `closedOnly` renders
+    // the closed hat alone, to subtract
+    constexpr int CUT = 8, BLOCKS = 16, WINDOW = 64;
+    auto render = [](bool closedOnly, int openSource, uint8_t choke) {
+        VoiceBank voices;
+        std::vector<float> out(BLOCKS * BENCH_BLOCK, 0.0f);
+        for (int b = 0; b < BLOCKS; b++) {
+            if (b == 0 && !closedOnly)
+                startVoice(voices, { &openHatSample, 1.0f, openSource, nullptr,
+                                     Trigger::Start, 1.0f, choke });
+            if (b == CUT)
+                startVoice(voices, { &hatSample, 1.0f, 2, nullptr,
+                                     Trigger::Start, 1.0f, choke });
+            mixVoices(voices, out.data() + b * BENCH_BLOCK, BENCH_BLOCK);
+        }
+        return out;
+    };
+    auto dbfs = [](double sumSquares, int n) {
+        return sumSquares > 0.0 ? 10.0 * log10(sumSquares / n) : -INFINITY;
+    };
+    std::vector<float> closed = render(true, 0, 0);
+    int at = CUT * BENCH_BLOCK;
+
+    struct Case { const char* name; int openSource; uint8_t choke; };
+    const Case cases[] = {
+        { "restart in place", 2, 0 },    // same source, no group
+        { "choke group",      3, 1 },
+    };
+    std::cout << std::left << std::setw(20) << "cut" << std::right
+              << std::setw(12) << "dBFS before" << std::setw(12) << "after"
+              << std::setw(14) << "tail frames" << "\n";
+    for (const Case& c : cases) {
+        std::vector<float> out = render(false, c.openSource, c.choke);
+        double before = 0.0, after = 0.0;
+        int tail = 0;
+        for (int i = at - WINDOW; i < int(out.size()); i++) {
+            double rest = out[i] - closed[i];
+            if (i < at) before += rest * rest;
+            else if (i < at + WINDOW) after += rest * rest;
+            if (i >= at && rest != 0.0) tail = i - at + 1;
+        }
+        std::cout << std::left << std::setw(20) << c.name << std::right
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(12) << dbfs(before, WINDOW)
+                  << std::setw(12) << dbfs(after, WINDOW)
+                  << std::setw(14) << tail << "\n";
+    }
+
+    // 16th hats, open on the off-beats: left to ring, or choked by the
+    // next closed one
+    std::cout << "mixer, open / closed hats every block (" << BENCH_BLOCKS
+              << " blocks of " << BENCH_BLOCK << "):\n";
+    for (uint8_t choke : { uint8_t(0), uint8_t(1) }) {
+        VoiceBank voices;
+        TriggerQueue triggers;
+        int peak = 0;
+        Result r = measure([&](int b) {
+            bool open = b % 2;
+            triggers.push({ open ? &openHatSample : &hatSample, 1.0f, open ? 3 : 2,
+                            nullptr, Trigger::Start, 1.0f, choke });
+            Trigger t;
+            while (triggers.pop(t))
+                startVoice(voices, t);
+            float mix[BENCH_BLOCK] = {};
+            mixVoices(voices, mix, BENCH_BLOCK);
+            peak = std::max(peak, voices.active);
+        }, BENCH_BLOCKS);
+        std::cout << "  " << std::left << std::setw(18)
+                  << (choke ? "choke group" : "no group") << std::right
+                  << std::setprecision(2) << std::setw(7) << r.nsPerBlock / 1000.0
+                  << " us/block, up to " << peak << " voices\n";
+    }
+}
+
+// =====================
+// MAIN
+// =====================
+struct Bench {
+    const char* name;
+    void (*run)();
+};
+
+const Bench BENCHES[] = {
+    { "mixer",    benchMixer },
+    { "compress", benchCompress },
+    { "layers",   benchLayers },
+    { "bass",     benchBass },
+    { "piano",    benchPiano },
+    { "kick",     benchKick },
+    { "rt",       benchRt },
+    { "mod",      benchMod },
+    { "analysis", benchAnalysis },
+    { "osc",      benchOsc },
+    { "jobs",     benchJobs },
+    { "resample", benchResample },
+    { "choke",    benchChoke },
+};
+
+int main(int argc, char** argv) {
+    renderBuffers();
+
+    for (const Bench& b : BENCHES) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; i++)
+            if (strcmp(argv[i], b.name) == 0) selected = true;
+        if (selected) b.run();
+    }
+}
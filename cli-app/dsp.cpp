@@ -0,0 +1,222 @@
+#include "dsp.h"
+
+// =====================
+// SNARE
+// =====================
+void generateSnare(float* out) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<double> noise(-1.0, 1.0);
+
+    double noiseLP = 0.0;
+    double outLP = 0.0;
+
+    for (int i = 0; i < SNARE_N; i++) {
+        double t = double(i) / SAMPLE_RATE;
+
+        double noiseEnv = exp(-t * 14.0) * (1.0 - exp(-t * 180.0));
+        double toneEnv  = exp(-t * 22.0);
+
+        double n = noise(rng) * noiseEnv;
+        n = lowpass(n, noiseLP, 5500.0);
+
+        double tone = sin(2.0 * M_PI * 150.0 * t);
+        tone = tanh(tone * 2.0) * toneEnv;
+
+        double s = 0.9 * n + 0.25 * tone;
+        s = lowpass(s, outLP, 6000.0);
+        s = tanh(s * 1.4);
+
+        out[i] = (float)s;
+    }
+}
+
+// =====================
+// KICK
+// =====================
+void generateKick(float* out) {
+    double phase = 0.0;
+
+    for (int i = 0; i < KICK_N; i++) {
+        double t = double(i) / SAMPLE_RATE;
+
+        double ampEnv = exp(-t * 8.0);
+        double freq = 40.0 + (80.0 - 40.0) * exp(-t * 20.0);
+
+        phase += 2.0 * M_PI * freq / SAMPLE_RATE;
+
+        double s = sin(phase) * ampEnv;
+        out[i] = (float)tanh(s * 1.2);
+    }
+}
+
+// =====================
+// HI-HAT
+// =====================
+// band-passed noise under an exponential decay of `rate` per second
+static void renderHat(float* out, int frames, double rate, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> noise(-1.0, 1.0);
+
+    double hp = 0.0;
+    double lp = 0.0;
+
+    for (int i = 0; i < frames; i++) {
+        double t = double(i) / SAMPLE_RATE;
+
+        double env = exp(-t * rate);
+
+        double n = noise(rng);
+
+        // crude band-pass: HP then LP
+        double high = n - lowpass(n, hp, 6000.0);
+        double band = lowpass(high, lp, 10000.0);
+
+        double s = band * env * 0.7;
+        out[i] = (float)tanh(s);
+    }
+}
+
+void generateHiHat(float* out) {
+    renderHat(out, HAT_N, 60.0, 5678);  // very fast decay
+}
+
+void generateOpenHiHat(float* out) {
+    renderHat(out, OPEN_HAT_N, 7.0, 8765);
+}
+
+// =====================
+// PIANO
+// =====================
+void PianoNote::start(double freq, bool sustain, double velocity,
+                      uint32_t seed, PianoModel model) {
+    this->freq = freq;
+    this->sustain = sustain;
+    this->model = model;
+    i = 0;
+
+    pitch = std::clamp(
+        (log2(freq / 55.0)) / 5.0,
+        0.0, 1.0
+    );
+
+    bass = freq < 110.0;
+
+    maxHarmonics = bass ? 3 : int(6 + pitch * 10);
+    inharmAmount = bass ? 0.00005 : (0.0002 + pitch * 0.001);
+    attackRate = bass ? 8.0 : (15.0 + pitch * 40.0);
+
+    boardMix = bass ? 0.85 : (0.8 - pitch * 0.35);
+    noiseLevel = bass ? 0.45 : (1.0 - pitch) * 0.2;
+
+    // --- VELOCITY ---
+    maxHarmonics =
+        std::max(1, int(lround(maxHarmonics * (0.4 + 0.6 * velocity))));
+    attackRate *= 0.5 + 0.5 * velocity;
+    noiseLevel *= 0.25 + 0.75 * velocity;
+    level = 0.35 + 0.65 * velocity;
+
+    rng.seed(seed);
+    noise.reset();
+
+    detune[0] = -0.0008 * pitch;
+    detune[1] =  0.0;
+    detune[2] = +0.0012 * pitch;
+
+    board[0] = board[1] = board[2] = board[3] = Resonator();
+    board[0].setup(90.0,  0.0015);
+    board[1].setup(180.0, 0.0025);
+    board[2].setup(420.0, 0.0035);
+    board[3].setup(900.0, 0.005);
+
+    air = Resonator();
+    air.setup(2500.0, 0.015);  // short “air splash”
+
+    if (model == PianoModel::Waveguide) {
+        // the additive partials decay at k * 2.5/s (4.5 in the bass);
+        // the strings take that over, `env` still does the rest.
+        // Dispersion is fitted on partial 4 or below, where the
+        // energy is.
+        for (int st = 0; st < 3; st++) {
+            double f = freq * (1.0 + detune[st]) * (1.0 + inharmAmount);
+            strings[st].setup(f, SAMPLE_RATE, inharmAmount,
+                              std::clamp(maxHarmonics, 2, 4),
+                              bass ? 4.5 : 2.5);
+            strings[st].pluck(1.0, freq * (maxHarmonics + 0.5),
+                              SAMPLE_RATE);
+        }
+    }
+}
+
+void PianoNote::render(float* buffer, int n) {
+    for (int j = 0; j < n; j++, i++) {
+        double t = double(i) / SAMPLE_RATE;
+
+        double env =
+            (1.0 - exp(-t * attackRate)) *
+            exp(-t * (sustain ? 0.35 : (bass ? 0.9 : 1.4)));
+
+        double s = model == PianoModel::Waveguide
+            ? waveguideStrings()
+            : additiveStrings(t);
+
+        // --- HAMMER SCRAPE (THIS IS THE KEY) ---
+        double hammerNoise =
+            noise(rng) *
+            exp(-t * (bass ? 120.0 : 220.0));
+
+        double hammer = hammerNoise * noiseLevel;
+
+        // metallic scrape burst
+        hammer +=
+            exp(-t * 90.0) *
+            sin(2.0 * M_PI * (bass ? 1800.0 : 3200.0) * t) *
+            (bass ? 0.25 : 0.08);
+
+        // --- SOUNDBOARD ---
+        double boardOut = 0.0;
+        for (int r = 0; r < 4; r++)
+            boardOut += board[r].process(s + hammer);
+
+        // --- AIR BLOOM ---
+        double airOut = air.process(s + hammer);
+
+        double sample =
+            (s * (1.0 - boardMix) +
+             boardOut * boardMix +
+             airOut * 0.15 +
+             hammer * 0.3) * env;
+
+        buffer[j] = (float)(tanh(sample * level * 1.25) * 0.3);
+    }
+}
+
+// --- STRINGS (de-idealized) ---
+double PianoNote::additiveStrings(double t) const {
+    double s = 0.0;
+
+    for (int st = 0; st < 3; st++) {
+        double f = freq * (1.0 + detune[st]);
+
+        for (int k = 1; k <= maxHarmonics; k++) {
+            double inharm = 1.0 + inharmAmount * k * k;
+            double hf = f * k * inharm;
+
+            double amp =
+                (1.0 / k) *
+                exp(-t * k * (bass ? 4.5 : 2.5));
+
+            // slight phase chaos in bass
+            double phaseJitter = bass ? sin(t * 1200.0) * 0.002 : 0.0;
+
+            s += amp * sin(2.0 * M_PI * hf * t + phaseJitter);
+        }
+    }
+    return s;
+}
+
+void generatePianoNote(float* buffer, double freq, bool sustain,
+                       double velocity, uint32_t seed, PianoModel model) {
+    auto note = std::make_unique<PianoNote>();
+    note->start(freq, sustain, velocity, seed, model);
+    note->render(buffer, PIANO_N);
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <random>
+
+#include "waveguide.h"
+
+constexpr int SAMPLE_RATE = 44100;
+
+// =====================
+// LENGTHS
+// =====================
+constexpr double SNARE_DUR = 0.15;
+constexpr double KICK_DUR  = 0.5;
+constexpr double HAT_DUR   = 0.08;
+constexpr double OPEN_HAT_DUR = 0.6;
+
+constexpr double PIANO_DUR = 2.5;
+constexpr int PIANO_N = int(PIANO_DUR * SAMPLE_RATE);
+constexpr int MAX_PIANO_NOTES = 20;
+
+constexpr int SNARE_N = int(SNARE_DUR * SAMPLE_RATE);
+constexpr int KICK_N  = int(KICK_DUR  * SAMPLE_RATE);
+constexpr int HAT_N   = int(HAT_DUR   * SAMPLE_RATE);
+constexpr int OPEN_HAT_N = int(OPEN_HAT_DUR * SAMPLE_RATE);
+
+// =====================
+// LOWPASS
+// =====================
+inline double lowpass(double input, double& state, double cutoffHz) {
+    double RC = 1.0 / (2.0 * M_PI * cutoffHz);
+    double dt = 1.0 / SAMPLE_RATE;
+    double alpha = dt / (RC + dt);
+    state += alpha * (input - state);
+    return state;
+}
+
+// =====================
+// DRUMS
+// =====================
+// One hit each into `out` (SNARE_N, KICK_N, HAT_N samples); fixed seeds,
+// so every call gives the same samples.
+void generateSnare(float* out);
+void generateKick(float* out);
+// closed, Linn-ish
+void generateHiHat(float* out);
+// the same cymbal left to ring (OPEN_HAT_N); a closed hat chokes it
+// (see VoiceBank)
+void generateOpenHiHat(float* out);
+
+// =====================
+// PIANO
+// =====================
+struct Resonator {
+    double y1 = 0.0, y2 = 0.0;
+    double a1, a2, b0;
+
+    void setup(double freq, double decay) {
+        double r = exp(-decay);
+        double w = 2.0 * M_PI * freq / SAMPLE_RATE;
+        a1 = -2.0 * r * cos(w);
+        a2 = r * r;
+        b0 = 1.0 - r;
+    }
+
+    inline double process(double x) {
+        double y = b0 * x - a1 * y1 - a2 * y2;
+        y2 = y1;
+        y1 = y;
+        return y;
+    }
+};
+
+enum class PianoModel {
+    Additive,   // up to 3 x 16 sinusoids per sample
+    Waveguide   // 3 waveguide strings, fixed cost per sample
+};
+
+// One piano note, rendered incrementally. velocity in (0, 1]: softer
+// notes get fewer harmonics, a slower hammer, less scrape and a lower
+// level. `seed` picks the hammer noise, so round-robin variants of one
+// note differ only in the strike.
+class PianoNote {
+public:
+    void start(double freq, bool sustain, double velocity = 1.0,
+               uint32_t seed = 0, PianoModel model = PianoModel::Waveguide);
+
+    void render(float* buffer, int n);
+
+private:
+    double additiveStrings(double t) const;
+
+    double waveguideStrings() {
+        return strings[0].process() + strings[1].process()
+             + strings[2].process();
+    }
+
+    double freq = 440.0;
+    bool sustain = false;
+    PianoModel model = PianoModel::Waveguide;
+    int i = 0;
+
+    double pitch = 0.0;
+    bool bass = false;
+    int maxHarmonics = 1;
+    double inharmAmount = 0.0;
+    double attackRate = 1.0;
+    double boardMix = 0.0;
+    double noiseLevel = 0.0;
+    double level = 1.0;
+    double detune[3] = {};
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<double> noise{ -1.0, 1.0 };
+
+    Resonator board[4];
+    Resonator air;
+    WaveguideString strings[3];
+};
+
+// whole PIANO_N note in one go; PianoNote is large, so it lives on the heap
+void generatePianoNote(float* buffer, double freq, bool sustain,
+                       double velocity = 1.0, uint32_t seed = 0,
+                       PianoModel model = PianoModel::Waveguide);
+
+inline const double pianoFreqs[MAX_PIANO_NOTES] = {
+    261.63, // C
+    277.18, // C#
+    293.66, // D
+    311.13, // D#
+    329.63, // E
+    349.23, // F
+    369.99, // F#
+    392.00, // G
+    415.30, // G#
+    440.00, // A
+    466.16, // A#
+    493.88, // B
+    523.25, // C
+    554.37, // C#
+    587.33, // D
+    622.25, // D#
+    659.25, // E
+    698.46, // F
+    739.99, // F#
+    783.99, // G
+};
@@ -0,0 +1,352 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/input.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#endif
+
+// =====================
+// KEY INPUT
+// =====================
+// Keys reach the synth as KeyEvents: the character the key types (so
+// the existing key maps apply unchanged), down or up, and the
+// CLOCK_MONOTONIC time the kernel saw it. Two sources:
+//
+//   EvdevInput   /dev/input/event* through epoll. Real key-up events,
+//                kernel timestamps, autorepeat dropped. Needs read
+//                access to the devices (the `input` group).
+//   StdinInput   the raw-mode terminal, nonblocking and read in
+//                batches. Key-down only, stamped when read, and the
+//                terminal's autorepeat comes through as repeated downs.
+//
+// and ScriptInput, which plays back a timed key script: repeatable
+// sessions without a keyboard (PGO training, soak runs).
+struct KeyEvent {
+    char key;       // 'a', 'D', ' ', '\n', ...
+    bool down;
+    int64_t timeNs; // CLOCK_MONOTONIC
+};
+
+inline int64_t monotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+class InputSource {
+public:
+    virtual ~InputSource() = default;
+
+    virtual const char* name() const = 0;
+    virtual bool hasKeyUp() const = 0;
+
+    // Waits up to timeoutMs (-1 = forever) and returns up to `max`
+    // events; 0 on timeout, -1 once the input is gone.
+    virtual int poll(KeyEvent* out, int max, int timeoutMs) = 0;
+};
+
+// =====================
+// STDIN
+// =====================
+// Raw mode: keys arrive one at a time, unechoed. Turn it off again
+// before exit, or the shell is left without echo.
+inline void setRawMode(bool enable) {
+    static termios oldt;
+    termios newt;
+
+    if (enable) {
+        tcgetattr(STDIN_FILENO, &oldt);
+        newt = oldt;
+        newt.c_lflag &= ~(ICANON | ECHO);
+        tcsetattr(STDIN_FILENO, TCSANOW, &newt);
+    } else {
+        tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
+    }
+}
+
+class StdinInput : public InputSource {
+public:
+    StdinInput() {
+        flags_ = fcntl(STDIN_FILENO, F_GETFL);
+        fcntl(STDIN_FILENO, F_SETFL, flags_ | O_NONBLOCK);
+#ifdef __linux__
+        epoll_ = epoll_create1(0);
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        // a regular file or /dev/null cannot be polled; read it directly
+        pollable_ = epoll_ctl(epoll_, EPOLL_CTL_ADD, STDIN_FILENO, &ev) == 0;
+#endif
+    }
+
+    ~StdinInput() override {
+        fcntl(STDIN_FILENO, F_SETFL, flags_);
+#ifdef __linux__
+        ::close(epoll_);
+#endif
+    }
+
+    const char* name() const override { return "stdin"; }
+    bool hasKeyUp() const override { return false; }
+
+    int poll(KeyEvent* out, int max, int timeoutMs) override {
+#ifdef __linux__
+        epoll_event ev;
+        if (pollable_ && epoll_wait(epoll_, &ev, 1, timeoutMs) <= 0)
+            return 0;
+#else
+        (void)timeoutMs;
+#endif
+        char buf[64];
+        ssize_t n = read(STDIN_FILENO, buf, std::min<size_t>(sizeof(buf), max));
+        if (n == 0) return -1;
+        if (n < 0) return errno == EAGAIN || errno == EINTR ? 0 : -1;
+
+        int64_t now = monotonicNs();
+        for (ssize_t i = 0; i < n; i++)
+            out[i] = { buf[i], true, now };
+        return int(n);
+    }
+
+private:
+    int flags_ = 0;
+    int epoll_ = -1;
+    bool pollable_ = false;
+};
+
+#ifdef __linux__
+
+// =====================
+// EVDEV
+// =====================
+// US layout: what each key types unshifted and shifted. The left and
+// right arrows give the last byte of their terminal escape sequences
+// (ESC [ D, ESC [ C), which is what the octave keys listen for.
+inline char evdevChar(int code, bool shift) {
+    static const struct { int code; char plain, shifted; } KEYS[] = {
+        { KEY_A, 'a', 'A' }, { KEY_B, 'b', 'B' }, { KEY_C, 'c', 'C' },
+        { KEY_D, 'd', 'D' }, { KEY_E, 'e', 'E' }, { KEY_F, 'f', 'F' },
+        { KEY_G, 'g', 'G' }, { KEY_H, 'h', 'H' }, { KEY_I, 'i', 'I' },
+        { KEY_J, 'j', 'J' }, { KEY_K, 'k', 'K' }, { KEY_L, 'l', 'L' },
+        { KEY_M, 'm', 'M' }, { KEY_N, 'n', 'N' }, { KEY_O, 'o', 'O' },
+        { KEY_P, 'p', 'P' }, { KEY_Q, 'q', 'Q' }, { KEY_R, 'r', 'R' },
+        { KEY_S, 's', 'S' }, { KEY_T, 't', 'T' }, { KEY_U, 'u', 'U' },
+        { KEY_V, 'v', 'V' }, { KEY_W, 'w', 'W' }, { KEY_X, 'x', 'X' },
+        { KEY_Y, 'y', 'Y' }, { KEY_Z, 'z', 'Z' },
+        { KEY_1, '1', '!' }, { KEY_2, '2', '@' }, { KEY_3, '3', '#' },
+        { KEY_4, '4', '$' }, { KEY_5, '5', '%' }, { KEY_6, '6', '^' },
+        { KEY_7, '7', '&' }, { KEY_8, '8', '*' }, { KEY_9, '9', '(' },
+        { KEY_0, '0', ')' },
+        { KEY_SEMICOLON, ';', ':' }, { KEY_APOSTROPHE, '\'', '"' },
+        { KEY_LEFTBRACE, '[', '{' }, { KEY_RIGHTBRACE, ']', '}' },
+        { KEY_BACKSLASH, '\\', '|' },
+        { KEY_MINUS, '-', '_' }, { KEY_EQUAL, '=', '+' },
+        { KEY_COMMA, ',', '<' }, { KEY_DOT, '.', '>' },
+        { KEY_SPACE, ' ', ' ' }, { KEY_ENTER, '\n', '\n' },
+        { KEY_TAB, '\t', '\t' },
+        { KEY_LEFT, 'D', 'D' }, { KEY_RIGHT, 'C', 'C' },
+    };
+    for (const auto& k : KEYS)
+        if (k.code == code)
+            return shift ? k.shifted : k.plain;
+    return 0;
+}
+
+class EvdevInput : public InputSource {
+public:
+    ~EvdevInput() override {
+        for (int fd : fds_) ::close(fd);
+        if (epoll_ >= 0) ::close(epoll_);
+    }
+
+    const char* name() const override { return "evdev"; }
+    bool hasKeyUp() const override { return true; }
+
+    // `device` = one event node, or empty for every keyboard found.
+    // False if none could be opened.
+    bool open(const std::string& device) {
+        epoll_ = epoll_create1(0);
+        if (epoll_ < 0) return false;
+
+        if (!device.empty()) {
+            addDevice(device.c_str());
+        } else {
+            for (int i = 0; i < 32; i++) {
+                char path[32];
+                snprintf(path, sizeof(path), "/dev/input/event%d", i);
+                addDevice(path);
+            }
+        }
+        return !fds_.empty();
+    }
+
+    int poll(KeyEvent* out, int max, int timeoutMs) override {
+        epoll_event ready[8];
+        int nready = epoll_wait(epoll_, ready, 8, timeoutMs);
+        if (nready < 0) return errno == EINTR ? 0 : -1;
+
+        // reads no more than fits in `out`; the rest waits in the kernel
+        // for the next call, so no key-up is ever dropped
+        int count = 0;
+        for (int r = 0; r < nready && count < max; r++) {
+            input_event ev[64];
+            size_t room = std::min<size_t>(64, size_t(max - count));
+            ssize_t n = read(ready[r].data.fd, ev, room * sizeof(input_event));
+            for (ssize_t i = 0; i < n / ssize_t(sizeof(input_event)); i++) {
+                if (ev[i].type != EV_KEY) continue;
+
+                int code = ev[i].code;
+                if (code == KEY_LEFTSHIFT || code == KEY_RIGHTSHIFT) {
+                    shift_ = ev[i].value != 0;
+                    continue;
+                }
+                if (ev[i].value == 2) continue;  // autorepeat
+
+                char c = evdevChar(code, shift_);
+                if (!c) continue;
+
+                out[count++] = {
+                    c, ev[i].value == 1,
+                    int64_t(ev[i].input_event_sec) * 1000000000
+                        + int64_t(ev[i].input_event_usec) * 1000
+                };
+            }
+        }
+        return count;
+    }
+
+private:
+    // keeps devices that have letter keys, with kernel timestamps on
+    // CLOCK_MONOTONIC so they compare with monotonicNs()
+    void addDevice(const char* path) {
+        int fd = ::open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) return;
+
+        unsigned long keys[KEY_MAX / (8 * sizeof(long)) + 1] = {};
+        auto has = [&](int k) {
+            return (keys[k / (8 * sizeof(long))] >> (k % (8 * sizeof(long)))) & 1;
+        };
+        int clock = CLOCK_MONOTONIC;
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+
+        if (ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keys)), keys) < 0
+            || !has(KEY_A) || !has(KEY_SPACE)
+            || ioctl(fd, EVIOCSCLOCKID, &clock) < 0
+            || epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            ::close(fd);
+            return;
+        }
+        fds_.push_back(fd);
+    }
+
+    int epoll_ = -1;
+    std::vector<int> fds_;
+    bool shift_ = false;
+};
+
+#endif
+
+// =====================
+// SCRIPT
+// =====================
+// One key per line, `#` starts a comment, times in seconds from open:
+//
+//   <seconds> <key> [up]
+//
+// <key> is the character typed, or space, enter or tab. Events are
+// delivered when due, stamped then; the input ends after the last one.
+class ScriptInput : public InputSource {
+public:
+    bool open(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) return false;
+
+        std::string line;
+        while (std::getline(file, line)) {
+            line = line.substr(0, line.find('#'));
+            std::istringstream in(line);
+            double seconds;
+            std::string key, up;
+            if (!(in >> seconds)) continue;
+            if (!(in >> key)) return false;
+            in >> up;
+
+            char c = key.size() == 1 ? key[0]
+                   : key == "space" ? ' '
+                   : key == "enter" ? '\n'
+                   : key == "tab"   ? '\t' : 0;
+            if (!c || (!up.empty() && up != "up")) return false;
+            int64_t at = int64_t(seconds * 1e9);
+            if (!events_.empty() && at < events_.back().timeNs) return false;
+            events_.push_back({ c, up.empty(), at });
+        }
+        start_ = monotonicNs();
+        return true;
+    }
+
+    const char* name() const override { return "script"; }
+    bool hasKeyUp() const override { return true; }
+
+    int poll(KeyEvent* out, int max, int timeoutMs) override {
+        if (next_ == events_.size()) return -1;
+
+        int64_t due = start_ + events_[next_].timeNs;
+        int64_t wait = due - monotonicNs();
+        if (timeoutMs >= 0)
+            wait = std::min<int64_t>(wait, int64_t(timeoutMs) * 1000000);
+        if (wait > 0)
+            std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+
+        int64_t now = monotonicNs();
+        int n = 0;
+        for (; n < max && next_ < events_.size()
+               && start_ + events_[next_].timeNs <= now; n++, next_++)
+            out[n] = { events_[next_].key, events_[next_].down, now };
+        return n;
+    }
+
+private:
+    std::vector<KeyEvent> events_;  // timeNs relative to start_
+    size_t next_ = 0;
+    int64_t start_ = 0;
+};
+
+// "evdev", "stdin", "script" (device = the script) or "auto" (evdev
+// when a keyboard can be read, else stdin). Null if the requested source
+// cannot be opened.
+inline std::unique_ptr<InputSource> openInput(const std::string& kind,
+                                              const std::string& device) {
+#ifdef __linux__
+    if (kind == "evdev" || kind == "auto") {
+        auto evdev = std::make_unique<EvdevInput>();
+        if (evdev->open(device)) return evdev;
+        if (kind == "evdev") return nullptr;
+    }
+#endif
+    if (kind == "stdin" || kind == "auto")
+        return std::make_unique<StdinInput>();
+    if (kind == "script") {
+        auto script = std::make_unique<ScriptInput>();
+        if (script->open(device)) return script;
+    }
+    return nullptr;
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "voices.h"
+
+// =====================
+// INSTRUMENT
+// =====================
+// A live-playable sound source. The host calls prepare() once, then
+// noteOn/noteOff and renderBlock from the audio thread. renderBlock adds
+// `frames` (<= the prepared max block) samples into `out` and must not
+// allocate, lock or block, so the same code runs live and offline.
+class Instrument {
+public:
+    virtual ~Instrument() = default;
+
+    virtual void prepare(int sampleRate, int maxBlock) = 0;
+    virtual void noteOn(int note, float velocity) = 0;  // MIDI note, 0..1
+    virtual void noteOff(int note) = 0;
+    virtual void renderBlock(float* out, int frames) = 0;
+
+    // MIDI-style continuous controller (1 = mod wheel, 74 = brightness),
+    // value 0..1, audio thread. Instruments without live parameters
+    // ignore it.
+    virtual void control(int cc, float value) {
+        (void)cc;
+        (void)value;
+    }
+
+    // True when nothing is sounding and rendering on from here gives the
+    // same samples as a freshly prepared instance that has been sent the
+    // same controller values. The offline renderer cuts a timeline into
+    // independent pieces only where this holds; false is always safe.
+    virtual bool idle() const { return false; }
+};
+
+// controller change handed to the audio thread
+struct ControlEvent {
+    int cc;
+    float value;
+};
+
+using ControlQueue = SpscQueue<ControlEvent>;
+
+// note on/off handed to the audio thread
+struct NoteEvent {
+    int note;
+    float velocity;  // 0 = note off
+};
+
+using NoteQueue = SpscQueue<NoteEvent>;
+
+inline double noteToFreq(int note) {
+    return 440.0 * pow(2.0, (note - 69) / 12.0);
+}
+
+// =====================
+// POLYPHONIC BASE
+// =====================
+// Fixed pool of `Voice`s with oldest-voice stealing. A Voice provides
+//
+//   void start(int note, float velocity, int sampleRate);
+//   bool render(float* out, int frames);   // adds; false once finished
+//
+// and a `static constexpr bool RELEASES`: if set, noteOff fades the voice
+// out over RELEASE_SEC instead of letting it ring to the end. A voice
+// with its own release stage (an envelope) defines `void release()`
+// instead, which noteOff calls; it keeps rendering until it says it is
+// finished. start() resets all of the voice's state, so an instrument
+// with no voice playing is idle().
+constexpr double RELEASE_SEC = 0.05;
+
+template <typename V, typename = void>
+struct HasRelease : std::false_type {};
+
+template <typename V>
+struct HasRelease<V, std::void_t<decltype(std::declval<V&>().release())>>
+    : std::true_type {};
+
+template <typename Voice, int POLYPHONY = 8>
+class PolyInstrument : public Instrument {
+public:
+    void prepare(int sampleRate, int maxBlock) override {
+        sampleRate_ = sampleRate;
+        maxBlock_ = std::min(maxBlock, MAX_BLOCK);
+        releaseN_ = std::max(1, int(RELEASE_SEC * sampleRate));
+        for (Slot& s : slots_)
+            s.active = false;
+    }
+
+    void noteOn(int note, float velocity) override {
+        claimVoice(note).start(note, velocity, sampleRate_);
+    }
+
+    void noteOff(int note) override {
+        for (Slot& s : slots_) {
+            if (!s.active || s.note != note) continue;
+            if constexpr (HasRelease<Voice>::value)
+                s.voice.release();
+            else if (Voice::RELEASES && s.releaseLeft < 0)
+                s.releaseLeft = releaseN_;
+        }
+    }
+
+    void renderBlock(float* out, int frames) override {
+        for (int done = 0; done < frames; ) {
+            int n = std::min(frames - done, maxBlock_);
+            for (Slot& s : slots_)
+                if (s.active) renderSlot(s, out + done, n);
+            done += n;
+        }
+    }
+
+    bool idle() const override {
+        for (const Slot& s : slots_)
+            if (s.active) return false;
+        return true;
+    }
+
+protected:
+    // Marks a slot (free, else the oldest) as playing `note` and returns
+    // its voice for the caller to start. For instruments that set
+    // per-hit voice state before start().
+    Voice& claimVoice(int note) {
+        Slot* slot = &slots_[0];
+        for (Slot& s : slots_) {
+            if (!s.active) {
+                slot = &s;
+                break;
+            }
+            if (s.age < slot->age) slot = &s;
+        }
+
+        slot->note = note;
+        slot->active = true;
+        slot->releaseLeft = -1;
+        slot->age = ++clock_;
+        return slot->voice;
+    }
+
+    int sampleRate() const { return sampleRate_; }
+
+private:
+    struct Slot {
+        Voice voice;
+        int note = 0;
+        bool active = false;
+        int releaseLeft = -1;  // samples of fade left, -1 = held
+        unsigned age = 0;
+    };
+
+    void renderSlot(Slot& s, float* out, int n) {
+        if (s.releaseLeft < 0) {
+            s.active = s.voice.render(out, n);
+            return;
+        }
+
+        std::fill(scratch_, scratch_ + n, 0.0f);
+        s.active = s.voice.render(scratch_, n);
+
+        float step = 1.0f / releaseN_;
+        int i = 0;
+        for (; i < n && s.releaseLeft > 0; i++, s.releaseLeft--)
+            out[i] += scratch_[i] * (s.releaseLeft * step);
+        if (s.releaseLeft == 0)
+            s.active = false;
+    }
+
+    Slot slots_[POLYPHONY];
+    float scratch_[MAX_BLOCK];
+    int sampleRate_ = 44100;
+    int maxBlock_ = MAX_BLOCK;
+    int releaseN_ = 1;
+    unsigned clock_ = 0;
+};
+
+// =====================
+// REGISTRY
+// =====================
+struct InstrumentInfo {
+    const char* name;
+    const char* description;
+    int defaultNote;       // note the original experiment rendered
+    double defaultSeconds; // its render length
+    std::unique_ptr<Instrument> (*create)();
+};
+
+template <typename T>
+std::unique_ptr<Instrument> makeInstrument() {
+    return std::make_unique<T>();
+}
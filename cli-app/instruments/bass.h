@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cmath>
+
+#include "../instrument.h"
+
+// =====================
+// BASS
+// =====================
+// Live version of bass-v1: same partials and envelopes, but every
+// harmonic is a second-order sine recurrence and every envelope a
+// per-sample multiplier fixed at noteOn, so a sample costs a handful of
+// multiply-adds and no libm calls. Harmonics above Nyquist are muted.
+//
+// Budget: BASS_BUDGET_US per voice per 256-frame block (under 0.1% of
+// the block period); `bench bass` checks it.
+constexpr double BASS_BUDGET_US = 5.0;
+
+struct BassVoice {
+    static constexpr bool RELEASES = true;
+    static constexpr int HARMONICS = 6;
+    static constexpr double ATTACK_SEC = 0.01;
+    static constexpr double DURATION_SEC = 2.5;
+
+    // per harmonic: y[n] = coef * y[n-1] - y[n-2], amplitude *= decay
+    double coef[HARMONICS];
+    double y1[HARMONICS];
+    double y2[HARMONICS];
+    double amp[HARMONICS];
+    double decay[HARMONICS];
+
+    // shared amplitude envelope: linear ramp, then geometric decay
+    double env = 0.0;
+    double attackStep = 0.0;
+    double envDecay = 1.0;
+    int attackN = 0;
+
+    int i = 0;
+    int numSamples = 0;
+    int sampleRate = 44100;
+    double gain = 1.0;
+
+    void start(int note, float velocity, int sr) {
+        double f = noteToFreq(note);
+
+        for (int k = 1; k <= HARMONICS; k++) {
+            double w = 2.0 * M_PI * k * f / sr;
+            bool audible = w < M_PI;
+
+            coef[k - 1]  = 2.0 * cos(w);
+            y1[k - 1]    = sin(-w);
+            y2[k - 1]    = sin(-2.0 * w);
+            amp[k - 1]   = audible ? 1.0 / (k * k) : 0.0;
+            decay[k - 1] = exp(-k * 1.5 / sr);
+        }
+
+        sampleRate = sr;
+        attackN = int(ceil(ATTACK_SEC * sr));
+        attackStep = 1.0 / (ATTACK_SEC * sr);
+        envDecay = exp(-1.5 / sr);
+        env = 0.0;
+
+        i = 0;
+        numSamples = int(DURATION_SEC * sr);
+        gain = velocity * 0.4;
+    }
+
+    bool render(float* out, int frames) {
+        int n = std::min(frames, numSamples - i);
+
+        for (int j = 0; j < n; j++, i++) {
+            double s = 0.0;
+            for (int k = 0; k < HARMONICS; k++) {
+                double y = coef[k] * y1[k] - y2[k];
+                y2[k] = y1[k];
+                y1[k] = y;
+                s += amp[k] * y;
+                amp[k] *= decay[k];
+            }
+
+            if (i < attackN) {
+                env = i * attackStep;
+            } else if (i == attackN) {
+                env = exp(-(double(i) / sampleRate - ATTACK_SEC) * 1.5);
+            } else {
+                env *= envDecay;
+            }
+
+            out[j] += (float)(s * env * gain);
+        }
+        return i < numSamples;
+    }
+};
+
+using Bass = PolyInstrument<BassVoice>;
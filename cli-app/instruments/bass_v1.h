@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cmath>
+
+#include "../instrument.h"
+
+// =====================
+// BASS V1 (from experiments/instruments/bass.cpp)
+// =====================
+// Six harmonics falling off as 1/k^2, 10 ms linear attack, exponential
+// decay. Note 36 plays the original 65.41 Hz C2. Evaluates sin and exp
+// per harmonic per sample; see bass.h for the live version.
+struct BassV1Voice {
+    static constexpr bool RELEASES = true;
+    static constexpr float PI = 3.141592653589793f;
+
+    float baseFreq = 65.41f;
+    int i = 0;
+    int numSamples = 0;
+    int sampleRate = 44100;
+    float gain = 1.0f;
+
+    void start(int note, float velocity, int sr) {
+        baseFreq = (float)noteToFreq(note);
+        sampleRate = sr;
+        i = 0;
+        numSamples = int(2.5f * sr);
+        gain = velocity;
+    }
+
+    bool render(float* out, int frames) {
+        int n = std::min(frames, numSamples - i);
+        for (int j = 0; j < n; j++, i++) {
+            float t = (float)i / sampleRate;
+
+            float attack = 0.01f;
+            float sample = 0.0f;
+
+            float amp;
+            if (t < attack)
+                amp = t / attack;
+            else
+                amp = exp(-(t - attack) * 1.5f);
+
+            for (int k = 1; k <= 6; k++) {
+                float harmonicAmp = (1.0f / (k * k)) * exp(-t * k * 1.5f);
+                sample += harmonicAmp * sin(2 * PI * k * baseFreq * t);
+            }
+
+            sample *= 0.4f;     // reduce volume
+            sample *= amp;      // apply envelope
+
+            out[j] += sample * gain;
+        }
+        return i < numSamples;
+    }
+};
+
+using BassV1 = PolyInstrument<BassV1Voice>;
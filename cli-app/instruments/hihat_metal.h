@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cmath>
+#include <random>
+
+#include "../instrument.h"
+
+// =====================
+// METALLIC HI-HAT (from experiments/instruments/snare.cpp)
+// =====================
+// Electronic closed hat: high-passed noise plus four inharmonic partials.
+// Unpitched; every hit replays the same seeded noise.
+struct HiHatMetalVoice {
+    static constexpr bool RELEASES = false;
+    static constexpr int NUM_PARTIALS = 4;
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<double> noise{ -1.0, 1.0 };
+    double prevNoise = 0.0;
+
+    int i = 0;
+    int numSamples = 0;
+    int sampleRate = 44100;
+    double gain = 1.0;
+
+    void start(int, float velocity, int sr) {
+        rng.seed(5678);
+        noise.reset();
+        prevNoise = 0.0;
+        sampleRate = sr;
+        i = 0;
+        numSamples = int(0.08 * sr);  // 80 ms closed hat
+        gain = velocity * (24000.0 / 32767.0);
+    }
+
+    bool render(float* out, int frames) {
+        // metallic partial frequencies (inharmonic)
+        static const double freqs[NUM_PARTIALS] = {
+            8000.0, 9500.0, 12000.0, 14500.0
+        };
+
+        int n = std::min(frames, numSamples - i);
+        for (int j = 0; j < n; j++, i++) {
+            double t = double(i) / sampleRate;
+
+            // very fast envelope
+            double env = exp(-t * 45.0);
+
+            // crude high-pass: subtract low component
+            double nz = noise(rng);
+            double hpNoise = nz - 0.98 * prevNoise;
+            prevNoise = nz;
+
+            // metallic ringing
+            double metal = 0.0;
+            for (int k = 0; k < NUM_PARTIALS; k++)
+                metal += sin(2.0 * M_PI * freqs[k] * t);
+            metal /= NUM_PARTIALS;
+
+            double sample = (0.7 * hpNoise + 0.5 * metal) * env;
+
+            out[j] += (float)(sample * gain);
+        }
+        return i < numSamples;
+    }
+};
+
+using HiHatMetal = PolyInstrument<HiHatMetalVoice, 4>;
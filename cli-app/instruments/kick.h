@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cmath>
+
+#include "../instrument.h"
+
+// =====================
+// KICK
+// =====================
+// Live version of generateKick: a phase-accumulator sine whose
+// increment follows an exponential pitch drop, times an exponential
+// amplitude decay, through a tanh drive. Sine, exp(-x) and tanh all come
+// from shared tables (linear interpolation), and each envelope is just
+// an index stepping through the exp table, so pitch and decay can be
+// retuned per hit at no cost. A sample is three table reads and a few
+// multiply-adds.
+struct KickParams {
+    double startFreq  = 80.0;  // Hz at the hit
+    double endFreq    = 40.0;  // Hz it settles to
+    double ampDecay   = 8.0;   // 1/s
+    double pitchDecay = 20.0;  // 1/s
+    double drive      = 1.2;
+};
+
+struct KickTables {
+    static constexpr int SINE_N = 2048;
+    static constexpr int EXP_N = 4096;
+    static constexpr double EXP_MAX = 16.0;   // exp(-16) ~ 1e-7
+    static constexpr int TANH_N = 1024;
+    static constexpr double TANH_MAX = 4.0;
+
+    float sine[SINE_N + 1];
+    float expNeg[EXP_N + 1];
+    float tanhT[TANH_N + 1];
+
+    KickTables() {
+        for (int i = 0; i <= SINE_N; i++)
+            sine[i] = (float)sin(2.0 * M_PI * i / SINE_N);
+        for (int i = 0; i <= EXP_N; i++)
+            expNeg[i] = (float)exp(-EXP_MAX * i / EXP_N);
+        for (int i = 0; i <= TANH_N; i++)
+            tanhT[i] = (float)tanh(TANH_MAX * (2.0 * i / TANH_N - 1.0));
+    }
+
+    // phase in [0, 1)
+    inline float sinLookup(float phase) const {
+        float x = phase * SINE_N;
+        int i = (int)x;
+        float f = x - i;
+        return sine[i] + f * (sine[i + 1] - sine[i]);
+    }
+
+    // x >= 0, in table steps (x = arg * EXP_N / EXP_MAX)
+    inline float expLookup(float x) const {
+        int i = (int)x;
+        if (i >= EXP_N) return 0.0f;
+        float f = x - i;
+        return expNeg[i] + f * (expNeg[i + 1] - expNeg[i]);
+    }
+
+    inline float tanhLookup(float s) const {
+        float x = (s + (float)TANH_MAX) * (TANH_N / (2.0f * (float)TANH_MAX));
+        x = std::clamp(x, 0.0f, (float)TANH_N - 0.001f);
+        int i = (int)x;
+        float f = x - i;
+        return tanhT[i] + f * (tanhT[i + 1] - tanhT[i]);
+    }
+};
+
+// built on first use; Kick::prepare touches it so that is never the
+// audio thread
+inline const KickTables& kickTables() {
+    static const KickTables tables;
+    return tables;
+}
+
+struct KickVoice {
+    static constexpr bool RELEASES = false;
+    static constexpr double END = 6.9;  // stop at exp(-6.9), -60 dB
+
+    const KickTables* tables = nullptr;
+
+    float phase = 0.0f;       // cycles, [0, 1)
+    float endInc = 0.0f;      // cycles per sample
+    float sweepInc = 0.0f;    // (start - end) cycles per sample
+    float ampX = 0.0f, ampStep = 0.0f;     // exp-table index and step
+    float pitchX = 0.0f, pitchStep = 0.0f;
+    float ampEnd = 0.0f;
+    float drive = 1.2f;
+    float gain = 1.0f;
+
+    KickParams params;  // set by Kick::noteOn before start()
+
+    void start(int note, float velocity, int sr) {
+        const double perArg = KickTables::EXP_N / KickTables::EXP_MAX;
+        double tune = noteToFreq(note) / noteToFreq(36);
+
+        tables = &kickTables();
+        phase = 0.0f;
+        endInc = float(params.endFreq * tune / sr);
+        sweepInc = float((params.startFreq - params.endFreq) * tune / sr);
+        ampX = 0.0f;
+        ampStep = float(params.ampDecay / sr * perArg);
+        pitchX = 0.0f;
+        pitchStep = float(params.pitchDecay / sr * perArg);
+        ampEnd = float(END * perArg);
+        drive = float(params.drive);
+        gain = velocity;
+    }
+
+    bool render(float* out, int frames) {
+        const KickTables& t = *tables;
+
+        for (int j = 0; j < frames; j++) {
+            float amp = t.expLookup(ampX);
+            float sweep = t.expLookup(pitchX);
+
+            phase += endInc + sweepInc * sweep;
+            phase -= (int)phase;
+
+            float s = t.sinLookup(phase) * amp;
+            out[j] += t.tanhLookup(s * drive) * gain;
+
+            ampX += ampStep;
+            pitchX += pitchStep;
+        }
+        return ampX < ampEnd;
+    }
+};
+
+class Kick : public PolyInstrument<KickVoice, 32> {
+public:
+    void prepare(int sampleRate, int maxBlock) override {
+        kickTables();
+        PolyInstrument::prepare(sampleRate, maxBlock);
+    }
+
+    // parameters for the following hits; audio thread, like noteOn
+    void setParams(const KickParams& p) { params_ = p; }
+
+    void noteOn(int note, float velocity) override {
+        KickVoice& v = claimVoice(note);
+        v.params = params_;
+        v.start(note, velocity, sampleRate());
+    }
+
+private:
+    KickParams params_;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cmath>
+
+#include "../instrument.h"
+
+// =====================
+// KICK FIXED (from experiments/instruments/kick-fixed.cpp)
+// =====================
+// Same sweep as kick-v1 with the phase accumulated per sample.
+struct KickFixedVoice {
+    static constexpr bool RELEASES = false;
+
+    int i = 0;
+    int numSamples = 0;
+    int sampleRate = 44100;
+    double startFreq = 120.0;
+    double endFreq = 40.0;
+    double phase = 0.0;
+    double gain = 1.0;
+
+    void start(int note, float velocity, int sr) {
+        double tune = noteToFreq(note) / noteToFreq(36);
+        sampleRate = sr;
+        i = 0;
+        numSamples = int(0.5 * sr);
+        startFreq = 120.0 * tune;
+        endFreq = 40.0 * tune;
+        phase = 0.0;
+        gain = velocity * (30000.0 / 32767.0);
+    }
+
+    bool render(float* out, int frames) {
+        int n = std::min(frames, numSamples - i);
+        for (int j = 0; j < n; j++, i++) {
+            double t = double(i) / sampleRate;
+
+            // Amplitude envelope (fast decay)
+            double ampEnv = exp(-t * 8.0);
+
+            // Pitch envelope (exponential drop)
+            double freq = endFreq + (startFreq - endFreq) * exp(-t * 20.0);
+
+            // Phase accumulation
+            phase += 2.0 * M_PI * freq / sampleRate;
+
+            out[j] += (float)(sin(phase) * ampEnv * gain);
+        }
+        return i < numSamples;
+    }
+};
+
+using KickFixed = PolyInstrument<KickFixedVoice>;
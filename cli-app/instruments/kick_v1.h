@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cmath>
+
+#include "../instrument.h"
+
+// =====================
+// KICK V1 (from experiments/instruments/kick-v1.cpp)
+// =====================
+// First kick attempt. The phase is computed as 2*pi*f(t)*t instead of
+// being accumulated, so the sweep overshoots; kept to compare against
+// kick-fixed. Note 36 plays the original 120 -> 40 Hz drop.
+struct KickV1Voice {
+    static constexpr bool RELEASES = false;
+
+    int i = 0;
+    int numSamples = 0;
+    int sampleRate = 44100;
+    double startFreq = 120.0;
+    double endFreq = 40.0;
+    double gain = 1.0;
+
+    void start(int note, float velocity, int sr) {
+        double tune = noteToFreq(note) / noteToFreq(36);
+        sampleRate = sr;
+        i = 0;
+        numSamples = int(0.5 * sr);
+        startFreq = 120.0 * tune;
+        endFreq = 40.0 * tune;
+        gain = velocity * (30000.0 / 32767.0);
+    }
+
+    bool render(float* out, int frames) {
+        int n = std::min(frames, numSamples - i);
+        for (int j = 0; j < n; j++, i++) {
+            double t = double(i) / sampleRate;
+
+            // Amplitude envelope (fast decay)
+            double ampEnv = exp(-t * 8.0);
+
+            // Pitch envelope (exponential drop)
+            double freq = endFreq + (startFreq - endFreq) * exp(-t * 20.0);
+
+            double phase = 2.0 * M_PI * freq * t;
+
+            out[j] += (float)(sin(phase) * ampEnv * gain);
+        }
+        return i < numSamples;
+    }
+};
+
+using KickV1 = PolyInstrument<KickV1Voice>;
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <cmath>
+
+#include "../instrument.h"
+#include "../modulation.h"
+
+// =====================
+// PAD
+// =====================
+// Two detuned PolyBLEP saws into a state-variable lowpass. The cutoff
+// follows a filter ADSR plus a slow LFO, the pitch a vibrato LFO, the
+// level an amplitude ADSR, and brightness (cc 74) and vibrato depth
+// (cc 1) can be moved live through smoothers.
+//
+// All of that runs at control rate: every CONTROL samples the voice
+// ticks its modulators and works out the filter coefficients (a tan())
+// and oscillator increments (an exp2()) for the end of the sub-block;
+// per sample they are only ramped. PadVoiceT<1> is the same voice
+// evaluated per sample, which `bench mod` compares against.
+struct PadParams {
+    Smoother cutoff;          // base cutoff, Hz
+    Smoother vibrato;         // vibrato depth, semitones
+    float resonance = 0.35f;  // 0..1
+    float envAmount = 3.0f;   // octaves of sweep at full filter envelope
+    float lfoAmount = 0.4f;   // octaves of slow cutoff wobble
+};
+
+template <int CONTROL>
+struct PadVoiceT {
+    static constexpr bool RELEASES = false;  // release() instead
+    static constexpr float DETUNE = 1.004f;  // ~7 cents each way
+
+    const PadParams* params = nullptr;  // set by PadT::noteOn
+
+    Adsr ampEnv, filterEnv;
+    Lfo vibratoLfo, filterLfo;
+
+    float freq = 440.0f;
+    float sampleRate = 44100.0f;
+    float gain = 1.0f;
+    float envAmount = 0.0f;
+
+    float phase[2] = {};
+    float ic1 = 0.0f, ic2 = 0.0f;  // SVF state
+
+    // control values at the end of the current sub-block, and ramps
+    // towards them
+    float lastAmp = 0.0f, lastInc[2] = {}, lastA[3] = {};
+    Ramp amp, inc[2], a[3];
+    int subLeft = 0;
+
+    void start(int note, float velocity, int sr) {
+        freq = float(noteToFreq(note));
+        sampleRate = float(sr);
+        gain = 0.25f * velocity;
+        envAmount = params->envAmount * (0.4f + 0.6f * velocity);
+
+        ampEnv.setup(0.08, 0.4, 0.7, 0.8, sr, CONTROL);
+        filterEnv.setup(0.02, 0.9, 0.25, 0.8, sr, CONTROL);
+        vibratoLfo.setup(Lfo::Sine, 5.5, sr, CONTROL);
+        filterLfo.setup(Lfo::Triangle, 0.3, sr, CONTROL);
+        vibratoLfo.reset();
+        filterLfo.reset(0.25f);
+        ampEnv.reset();
+        filterEnv.reset();
+        ampEnv.gateOn();
+        filterEnv.gateOn();
+
+        phase[0] = 0.0f;
+        phase[1] = 0.5f;
+        ic1 = ic2 = 0.0f;
+        lastAmp = 0.0f;
+        subLeft = 0;
+        controlTick(true);
+    }
+
+    void release() {
+        ampEnv.gateOff();
+        filterEnv.gateOff();
+    }
+
+    bool render(float* out, int frames) {
+        for (int j = 0; j < frames; j++) {
+            if (subLeft == 0) {
+                if (!ampEnv.active()) return false;
+                controlTick(false);
+            }
+            subLeft--;
+
+            float x = saw(phase[0], inc[0].next())
+                    + saw(phase[1], inc[1].next());
+
+            // TPT state-variable filter, lowpass output
+            float a1 = a[0].next(), a2 = a[1].next(), a3 = a[2].next();
+            float v3 = x - ic2;
+            float v1 = a1 * ic1 + a2 * v3;
+            float v2 = ic2 + a2 * ic1 + a3 * v3;
+            ic1 = 2.0f * v1 - ic1;
+            ic2 = 2.0f * v2 - ic2;
+
+            out[j] += v2 * amp.next() * gain;
+        }
+        return ampEnv.active();
+    }
+
+private:
+    // modulators one step on, targets for the end of the sub-block
+    void controlTick(bool first) {
+        float env = ampEnv.tick();
+        float fenv = filterEnv.tick();
+        float vib = vibratoLfo.tick();
+        float wobble = filterLfo.tick();
+
+        float bend = exp2f(params->vibrato.value() * vib / 12.0f);
+        float incs[2] = { freq * bend * DETUNE / sampleRate,
+                          freq * bend / DETUNE / sampleRate };
+
+        float cutoff = params->cutoff.value()
+                     * exp2f(envAmount * fenv + params->lfoAmount * wobble);
+        cutoff = std::clamp(cutoff, 20.0f, 0.45f * sampleRate);
+        float g = tanf(float(M_PI) * cutoff / sampleRate);
+        float k = 2.0f - 1.9f * params->resonance;
+        float a1 = 1.0f / (1.0f + g * (g + k));
+        float coefs[3] = { a1, g * a1, g * g * a1 };
+
+        if (first) {
+            lastInc[0] = incs[0];
+            lastInc[1] = incs[1];
+            for (int c = 0; c < 3; c++) lastA[c] = coefs[c];
+        }
+
+        amp = rampTo(lastAmp, env, CONTROL);
+        for (int o = 0; o < 2; o++) inc[o] = rampTo(lastInc[o], incs[o], CONTROL);
+        for (int c = 0; c < 3; c++) a[c] = rampTo(lastA[c], coefs[c], CONTROL);
+        subLeft = CONTROL;
+    }
+
+    // PolyBLEP sawtooth, advances `p`
+    static inline float saw(float& p, float dt) {
+        float y = 2.0f * p - 1.0f;
+        if (p < dt) {
+            float t = p / dt;
+            y -= t + t - t * t - 1.0f;
+        } else if (p > 1.0f - dt) {
+            float t = (p - 1.0f) / dt;
+            y -= t * t + t + t + 1.0f;
+        }
+        p += dt;
+        p -= (int)p;
+        return y;
+    }
+};
+
+template <int CONTROL>
+class PadT : public PolyInstrument<PadVoiceT<CONTROL>, 8> {
+    using Base = PolyInstrument<PadVoiceT<CONTROL>, 8>;
+
+public:
+    void prepare(int sampleRate, int maxBlock) override {
+        params_.cutoff.setup(0.05, sampleRate, CONTROL);
+        params_.cutoff.reset(600.0f);
+        params_.vibrato.setup(0.1, sampleRate, CONTROL);
+        params_.vibrato.reset(0.12f);
+        Base::prepare(sampleRate, maxBlock);
+    }
+
+    void noteOn(int note, float velocity) override {
+        PadVoiceT<CONTROL>& v = this->claimVoice(note);
+        v.params = &params_;
+        v.start(note, velocity, this->sampleRate());
+    }
+
+    // glides while something is sounding, jumps while nothing is
+    void control(int cc, float value) override {
+        value = std::clamp(value, 0.0f, 1.0f);
+        Smoother* s = cc == 74 ? &params_.cutoff
+                    : cc == 1  ? &params_.vibrato : nullptr;
+        if (!s) return;
+
+        float target = cc == 74 ? 100.0f * exp2f(7.0f * value) : value;
+        if (Base::idle()) s->reset(target);
+        else s->setTarget(target);
+    }
+
+    bool idle() const override {
+        return Base::idle() && params_.cutoff.settled()
+            && params_.vibrato.settled();
+    }
+
+    // the smoothers step once per sub-block, like the voices' modulators
+    void renderBlock(float* out, int frames) override {
+        for (int done = 0; done < frames; done += CONTROL) {
+            params_.cutoff.tick();
+            params_.vibrato.tick();
+            Base::renderBlock(out + done, std::min(CONTROL, frames - done));
+        }
+    }
+
+private:
+    PadParams params_;
+};
+
+using PadVoice = PadVoiceT<CONTROL_BLOCK>;
+using Pad = PadT<CONTROL_BLOCK>;
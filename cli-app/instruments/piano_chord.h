@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cmath>
+
+#include "../instrument.h"
+
+// =====================
+// ADDITIVE PIANO CHORD (from experiments/instruments/piano.cpp)
+// =====================
+// Major triad on the played note, 8 decaying harmonics per tone. Note
+// 60 plays the original C4-E4-G4.
+struct PianoChordVoice {
+    static constexpr bool RELEASES = true;
+    static constexpr float PI = 3.141592653589793f;
+
+    float freqs[3] = {};
+    int i = 0;
+    int numSamples = 0;
+    int sampleRate = 44100;
+    float gain = 1.0f;
+
+    void start(int note, float velocity, int sr) {
+        freqs[0] = (float)noteToFreq(note);
+        freqs[1] = (float)noteToFreq(note + 4);
+        freqs[2] = (float)noteToFreq(note + 7);
+        sampleRate = sr;
+        i = 0;
+        numSamples = int(2.0f * sr);
+        gain = velocity;
+    }
+
+    bool render(float* out, int frames) {
+        int n = std::min(frames, numSamples - i);
+        for (int j = 0; j < n; j++, i++) {
+            float t = (float)i / sampleRate;
+
+            float amp = exp(-t * 2.5f);
+            float sample = 0.0f;
+
+            for (int c = 0; c < 3; c++) {
+                float f = freqs[c];
+                for (int k = 1; k <= 8; k++) {
+                    float harmonicAmp = (1.0f / k) * exp(-t * k * 3.0f);
+                    sample += harmonicAmp * sin(2 * PI * k * f * t);
+                }
+            }
+
+            sample *= 0.2f;     // reduce volume
+            sample *= amp;      // apply envelope
+
+            out[j] += sample * gain;
+        }
+        return i < numSamples;
+    }
+};
+
+using PianoChord = PolyInstrument<PianoChordVoice>;
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstring>
+
+#include "../instrument.h"
+#include "bass.h"
+#include "bass_v1.h"
+#include "hihat_metal.h"
+#include "kick.h"
+#include "kick_fixed.h"
+#include "kick_v1.h"
+#include "pad.h"
+#include "piano_chord.h"
+#include "simple_chord.h"
+#include "snare_imagine.h"
+
+// =====================
+// REGISTERED INSTRUMENTS
+// =====================
+inline const InstrumentInfo INSTRUMENTS[] = {
+    { "kick-v1",       "kick, phase computed from t (original bug)", 36, 0.5,  makeInstrument<KickV1> },
+    { "kick-fixed",    "kick, accumulated phase",                     36, 0.5,  makeInstrument<KickFixed> },
+    { "kick",          "kick, wavetable + envelope tables",           36, 0.5,  makeInstrument<Kick> },
+    { "hihat-metal",   "electronic closed hat, noise + partials",     60, 0.08, makeInstrument<HiHatMetal> },
+    { "snare-imagine", "acoustic snare, filtered noise + body",       60, 0.15, makeInstrument<SnareImagine> },
+    { "piano-chord",   "additive piano, major triad",                 60, 2.0,  makeInstrument<PianoChord> },
+    { "simple-chord",  "three sines, major triad",                    60, 2.0,  makeInstrument<SimpleChord> },
+    { "bass-v1",       "six-harmonic bass, per-sample sin/exp",       36, 2.5,  makeInstrument<BassV1> },
+    { "bass",          "six-harmonic bass, recurrence oscillators",   36, 2.5,  makeInstrument<Bass> },
+    { "pad",           "saws + SVF, ADSR/LFO at control rate",        48, 3.0,  makeInstrument<Pad> },
+};
+
+inline const InstrumentInfo* findInstrument(const char* name) {
+    for (const InstrumentInfo& info : INSTRUMENTS)
+        if (strcmp(info.name, name) == 0)
+            return &info;
+    return nullptr;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cmath>
+
+#include "../instrument.h"
+
+// =====================
+// SIMPLE CHORD (from experiments/instruments/simple-chord.cpp)
+// =====================
+// Three plain sines (major triad on the played note) with a half-second
+// fade in and out over two seconds.
+struct SimpleChordVoice {
+    static constexpr bool RELEASES = true;
+    static constexpr float PI = 3.141592653589793f;
+    static constexpr float DURATION = 2.0f;
+
+    float freqs[3] = {};
+    int i = 0;
+    int numSamples = 0;
+    int sampleRate = 44100;
+    float gain = 1.0f;
+
+    void start(int note, float velocity, int sr) {
+        freqs[0] = (float)noteToFreq(note);
+        freqs[1] = (float)noteToFreq(note + 4);
+        freqs[2] = (float)noteToFreq(note + 7);
+        sampleRate = sr;
+        i = 0;
+        numSamples = int(DURATION * sr);
+        gain = velocity;
+    }
+
+    bool render(float* out, int frames) {
+        int n = std::min(frames, numSamples - i);
+        for (int j = 0; j < n; j++, i++) {
+            float t = (float)i / sampleRate;
+
+            float attack = 0.5f;   // first 0.5 sec fade in
+            float decay  = 0.5f;   // last 0.5 sec fade out
+            float amp = 1.0f;
+
+            if (t < attack)
+                amp *= (t / attack);
+            if (t > DURATION - decay)
+                amp *= (DURATION - t) / decay;
+
+            float sample =
+                sin(2 * PI * freqs[0] * t) +
+                sin(2 * PI * freqs[1] * t) +
+                sin(2 * PI * freqs[2] * t);
+
+            sample *= 0.3f;     // reduce volume
+            sample *= amp;      // apply envelope
+
+            out[j] += sample * gain;
+        }
+        return i < numSamples;
+    }
+};
+
+using SimpleChord = PolyInstrument<SimpleChordVoice>;
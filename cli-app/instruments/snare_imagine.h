@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cmath>
+#include <random>
+
+#include "../dsp.h"
+#include "../instrument.h"
+
+// =====================
+// IMAGINE SNARE (from experiments/instruments/snare-imgn.cpp)
+// =====================
+// Imagine-style acoustic snare: low-passed noise for the wires over a
+// saturated 150 Hz body, then tape-style shaping. Unpitched.
+struct SnareImagineVoice {
+    static constexpr bool RELEASES = false;
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<double> noise{ -1.0, 1.0 };
+    double noiseLP = 0.0;
+    double outLP = 0.0;
+
+    int i = 0;
+    int numSamples = 0;
+    int sampleRate = 44100;
+    double gain = 1.0;
+
+    void start(int, float velocity, int sr) {
+        rng.seed(1234);
+        noise.reset();
+        noiseLP = 0.0;
+        outLP = 0.0;
+        sampleRate = sr;
+        i = 0;
+        numSamples = int(0.15 * sr);
+        gain = velocity * (28000.0 / 32767.0);
+    }
+
+    bool render(float* out, int frames) {
+        int n = std::min(frames, numSamples - i);
+        for (int j = 0; j < n; j++, i++) {
+            double t = double(i) / sampleRate;
+
+            // Rounded envelopes (very important)
+            double noiseEnv = exp(-t * 14.0) * (1.0 - exp(-t * 180.0));
+            double toneEnv  = exp(-t * 22.0);
+
+            // Band-limited noise (snare wires)
+            double nz = noise(rng) * noiseEnv;
+            nz = lowpass(nz, noiseLP, 5500.0);
+
+            // Low, dirty body tone
+            double tone = sin(2.0 * M_PI * 150.0 * t);
+            tone = tanh(tone * 2.0) * toneEnv;
+
+            // Mix, then tape / console shaping
+            double sample = 0.9 * nz + 0.25 * tone;
+            sample = lowpass(sample, outLP, 6000.0);
+            sample = tanh(sample * 1.4);
+
+            out[j] += (float)(sample * gain);
+        }
+        return i < numSamples;
+    }
+};
+
+using SnareImagine = PolyInstrument<SnareImagineVoice, 4>;
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+// =====================
+// CONTROL-RATE MODULATION
+// =====================
+// Envelopes, LFOs and smoothers advance once per CONTROL_BLOCK samples
+// (tick()), and whatever they drive is ramped linearly across the
+// sub-block with a Ramp. Anything expensive that depends on them (a
+// filter's tan(), a pitch's pow()) is then evaluated once per sub-block
+// instead of once per sample.
+constexpr int CONTROL_BLOCK = 16;
+
+// a control value moving linearly across one sub-block
+struct Ramp {
+    float value = 0.0f;
+    float step = 0.0f;
+
+    inline float next() {
+        float v = value;
+        value += step;
+        return v;
+    }
+};
+
+// Ramp from `last` to `target` over `n` samples; `last` becomes target.
+inline Ramp rampTo(float& last, float target, int n) {
+    Ramp r{ last, (target - last) / n };
+    last = target;
+    return r;
+}
+
+// =====================
+// SMOOTHER
+// =====================
+// One-pole glide towards a target, for parameters set from outside
+// (keys, MIDI CCs) so a jump does not click. `seconds` is the time
+// constant.
+class Smoother {
+public:
+    void setup(double seconds, int sampleRate, int controlBlock = CONTROL_BLOCK) {
+        coef_ = float(exp(-controlBlock / (std::max(1e-4, seconds) * sampleRate)));
+    }
+
+    void reset(float v) { current_ = target_ = v; }
+    void setTarget(float v) { target_ = v; }
+
+    // once the glide stops moving (it can stall an ulp short) it lands
+    float tick() {
+        float next = target_ + coef_ * (current_ - target_);
+        current_ = next == current_ ? target_ : next;
+        return current_;
+    }
+
+    float value() const { return current_; }
+    float target() const { return target_; }
+    bool settled() const { return current_ == target_; }
+
+private:
+    float coef_ = 0.0f;
+    float current_ = 0.0f;
+    float target_ = 0.0f;
+};
+
+// =====================
+// ADSR
+// =====================
+// Linear attack, exponential decay and release (each reaches ~-60 dB of
+// its distance in the given time), output 0..1.
+class Adsr {
+public:
+    enum Stage { Idle, Attack, Decay, Sustain, Release };
+
+    void setup(double attack, double decay, double sustain, double release,
+               int sampleRate, int controlBlock = CONTROL_BLOCK) {
+        double ticksPerSec = double(sampleRate) / controlBlock;
+        attackStep_ = float(1.0 / std::max(1.0, attack * ticksPerSec));
+        decayCoef_ = segmentCoef(decay, ticksPerSec);
+        releaseCoef_ = segmentCoef(release, ticksPerSec);
+        sustain_ = float(std::clamp(sustain, 0.0, 1.0));
+    }
+
+    void reset() {
+        stage_ = Idle;
+        value_ = 0.0f;
+    }
+
+    void gateOn() { stage_ = Attack; }
+
+    void gateOff() {
+        if (stage_ != Idle) stage_ = Release;
+    }
+
+    float tick() {
+        switch (stage_) {
+        case Idle:
+            break;
+        case Attack:
+            value_ += attackStep_;
+            if (value_ >= 1.0f) {
+                value_ = 1.0f;
+                stage_ = Decay;
+            }
+            break;
+        case Decay:
+            value_ = sustain_ + decayCoef_ * (value_ - sustain_);
+            if (value_ - sustain_ < 1e-4f) {
+                value_ = sustain_;
+                stage_ = Sustain;
+            }
+            break;
+        case Sustain:
+            break;
+        case Release:
+            value_ *= releaseCoef_;
+            if (value_ < 1e-4f) {
+                value_ = 0.0f;
+                stage_ = Idle;
+            }
+            break;
+        }
+        return value_;
+    }
+
+    float value() const { return value_; }
+    Stage stage() const { return stage_; }
+    bool active() const { return stage_ != Idle; }
+
+private:
+    static float segmentCoef(double seconds, double ticksPerSec) {
+        return float(exp(-6.9 / std::max(1.0, seconds * ticksPerSec)));
+    }
+
+    Stage stage_ = Idle;
+    float value_ = 0.0f;
+    float attackStep_ = 1.0f;
+    float decayCoef_ = 0.0f;
+    float releaseCoef_ = 0.0f;
+    float sustain_ = 1.0f;
+};
+
+// =====================
+// LFO
+// =====================
+// Output -1..1.
+class Lfo {
+public:
+    enum Shape { Sine, Triangle, Saw, Square };
+
+    void setup(Shape shape, double rateHz, int sampleRate,
+               int controlBlock = CONTROL_BLOCK) {
+        shape_ = shape;
+        inc_ = float(rateHz * controlBlock / sampleRate);
+    }
+
+    void reset(float phase = 0.0f) { phase_ = phase; }
+
+    float tick() {
+        phase_ += inc_;
+        phase_ -= floorf(phase_);
+
+        switch (shape_) {
+        case Sine:     return sinf(2.0f * float(M_PI) * phase_);
+        case Triangle: return 1.0f - 4.0f * fabsf(phase_ - 0.5f);
+        case Saw:      return 2.0f * phase_ - 1.0f;
+        case Square:   return phase_ < 0.5f ? 1.0f : -1.0f;
+        }
+        return 0.0f;
+    }
+
+private:
+    Shape shape_ = Sine;
+    float phase_ = 0.0f;
+    float inc_ = 0.0f;
+};
@@ -0,0 +1,389 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "dsp.h"
+#include "input.h"
+#include "spsc_queue.h"
+
+// =====================
+// OSC PARSING
+// =====================
+// OSC 1.0 messages and bundles, read in place: nothing is copied or
+// allocated, an OscMessage points into the packet. Bundles are unpacked
+// (nested too); their time tags are ignored and every element plays on
+// arrival, like a key press.
+struct OscMessage {
+    const char* address;
+    const char* types;      // type tags after the ','
+    const uint8_t* args;
+    const uint8_t* end;
+};
+
+// Reads a message's arguments in order. Each getter is false (and reads
+// nothing) when the next argument is missing or of another type;
+// number() takes an int or a float.
+class OscArgs {
+public:
+    explicit OscArgs(const OscMessage& m) : tag_(m.types), at_(m.args), end_(m.end) {}
+
+    bool int32(int32_t& v) {
+        if (*tag_ != 'i' || end_ - at_ < 4) return false;
+        v = int32_t(word());
+        return true;
+    }
+
+    bool float32(float& v) {
+        if (*tag_ != 'f' || end_ - at_ < 4) return false;
+        uint32_t bits = word();
+        memcpy(&v, &bits, 4);
+        return true;
+    }
+
+    bool number(float& v) {
+        int32_t i;
+        if (int32(i)) {
+            v = float(i);
+            return true;
+        }
+        return float32(v);
+    }
+
+private:
+    uint32_t word() {
+        uint32_t v = uint32_t(at_[0]) << 24 | uint32_t(at_[1]) << 16
+                   | uint32_t(at_[2]) << 8 | uint32_t(at_[3]);
+        at_ += 4;
+        tag_++;
+        return v;
+    }
+
+    const char* tag_;
+    const uint8_t* at_;
+    const uint8_t* end_;
+};
+
+// A NUL-terminated string padded to 4 bytes at `at`; the byte after the
+// padding, or null if it runs past `end`.
+inline const uint8_t* oscSkipString(const uint8_t* at, const uint8_t* end) {
+    const uint8_t* nul = (const uint8_t*)memchr(at, 0, size_t(end - at));
+    if (!nul) return nullptr;
+    size_t padded = (size_t(nul - at) + 4) & ~size_t(3);
+    return padded <= size_t(end - at) ? at + padded : nullptr;
+}
+
+// Calls fn(const OscMessage&) for every message in the packet; false if
+// it is malformed (messages before the fault have been delivered).
+template <typename Fn>
+bool parseOsc(const uint8_t* data, size_t size, Fn&& fn, int depth = 0) {
+    const uint8_t* end = data + size;
+    if (size < 4 || size % 4 != 0 || depth > 4) return false;
+
+    if (data[0] == '#') {
+        if (size < 16 || memcmp(data, "#bundle", 8) != 0) return false;
+        for (const uint8_t* at = data + 16; at < end; ) {
+            if (end - at < 4) return false;
+            uint32_t n = uint32_t(at[0]) << 24 | uint32_t(at[1]) << 16
+                       | uint32_t(at[2]) << 8 | uint32_t(at[3]);
+            at += 4;
+            if (n > size_t(end - at) || !parseOsc(at, n, fn, depth + 1))
+                return false;
+            at += n;
+        }
+        return true;
+    }
+
+    if (data[0] != '/') return false;
+    const uint8_t* types = oscSkipString(data, end);
+    if (!types || *types != ',') return false;
+    const uint8_t* args = oscSkipString(types, end);
+    if (!args) return false;
+
+    fn(OscMessage{ (const char*)data, (const char*)types + 1, args, end });
+    return true;
+}
+
+// =====================
+// OSC EVENTS
+// =====================
+// What the synth understands, as the audio thread gets it:
+//
+//   /drum/snare, /drum/kick, /drum/hat, /drum/openhat  [velocity]
+//   /piano  <key 0..19> [velocity]      velocity 0 = note-off
+//   /note   <note> [velocity]           the --instrument, if any
+//   /cc     <number> <value>            likewise
+//   /pedal  <0|1>
+//
+// Numbers may be int or float; a missing velocity is 1. They come off
+// the network, so a message with a NaN or infinite number, or an index
+// out of range (piano key 0..19, note and controller 0..127), is
+// dropped, and velocities and values are clamped to [0, 1].
+struct OscEvent {
+    enum Kind : uint8_t { Drum, Piano, Note, Control, Pedal };
+    enum DrumId : uint8_t { Snare, Kick, Hat, OpenHat };
+
+    Kind kind;
+    int16_t index;    // DrumId, piano key, note or controller
+    float value;      // velocity, controller value or pedal
+    int64_t timeNs;   // arrival, CLOCK_MONOTONIC
+};
+
+using OscQueue = SpscQueue<OscEvent, 1024>;
+
+constexpr int OSC_MIDI_RANGE = 128;  // notes and controllers
+
+// `x` as an index in [0, count); false for anything else, NaN included
+inline bool oscIndex(float x, int count, int16_t& index) {
+    if (!(x >= 0.0f && x < float(count))) return false;
+    index = int16_t(x);
+    return true;
+}
+
+// `v` clamped to [0, 1]; false if it is not finite
+inline bool oscUnit(float& v) {
+    if (!std::isfinite(v)) return false;
+    v = std::clamp(v, 0.0f, 1.0f);
+    return true;
+}
+
+inline bool oscToEvent(const OscMessage& m, OscEvent& e) {
+    OscArgs args(m);
+    float index = 0.0f;
+    e.value = 1.0f;
+
+    if (strncmp(m.address, "/drum/", 6) == 0) {
+        const char* name = m.address + 6;
+        e.kind = OscEvent::Drum;
+        if (strcmp(name, "snare") == 0) e.index = OscEvent::Snare;
+        else if (strcmp(name, "kick") == 0) e.index = OscEvent::Kick;
+        else if (strcmp(name, "hat") == 0) e.index = OscEvent::Hat;
+        else if (strcmp(name, "openhat") == 0) e.index = OscEvent::OpenHat;
+        else return false;
+        args.number(e.value);
+        return oscUnit(e.value);
+    }
+    if (strcmp(m.address, "/piano") == 0 || strcmp(m.address, "/note") == 0) {
+        e.kind = m.address[1] == 'p' ? OscEvent::Piano : OscEvent::Note;
+        if (!args.number(index)) return false;
+        args.number(e.value);
+        return oscIndex(index, e.kind == OscEvent::Piano ? MAX_PIANO_NOTES
+                                                         : OSC_MIDI_RANGE, e.index)
+            && oscUnit(e.value);
+    }
+    if (strcmp(m.address, "/cc") == 0) {
+        e.kind = OscEvent::Control;
+        if (!args.number(index) || !args.number(e.value)) return false;
+        return oscIndex(index, OSC_MIDI_RANGE, e.index) && oscUnit(e.value);
+    }
+    if (strcmp(m.address, "/pedal") == 0) {
+        e.kind = OscEvent::Pedal;
+        e.index = 0;
+        return args.number(e.value) && oscUnit(e.value);
+    }
+    return false;
+}
+
+// =====================
+// OSC LISTENER
+// =====================
+// A thread on a UDP socket that parses each datagram in a fixed buffer
+// and pushes its events, stamped with the time the read returned, into
+// an OscQueue for the audio thread. Datagrams are read in batches
+// (recvmmsg on Linux). Nothing here allocates once start() has run.
+class OscListener {
+public:
+    static constexpr int BATCH = 32;
+    static constexpr int MAX_PACKET = 1536;
+
+    ~OscListener() { stop(); }
+
+    // "PORT" (loopback only) or "HOST:PORT"; port 0 picks a free one.
+    // False with `error` set if the socket cannot be bound.
+    bool open(const std::string& where, std::string& error) {
+        size_t colon = where.rfind(':');
+        std::string host = colon == std::string::npos ? "127.0.0.1"
+                                                      : where.substr(0, colon);
+        std::string port = colon == std::string::npos ? where
+                                                      : where.substr(colon + 1);
+
+        addrinfo hints = {}, *res = nullptr;
+        hints.ai_socktype = SOCK_DGRAM;
+        hints.ai_flags = AI_PASSIVE;
+        if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0) {
+            error = "osc: cannot resolve " + where;
+            return false;
+        }
+        for (addrinfo* a = res; a && fd_ < 0; a = a->ai_next) {
+            fd_ = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+            if (fd_ >= 0 && bind(fd_, a->ai_addr, a->ai_addrlen) != 0) {
+                ::close(fd_);
+                fd_ = -1;
+            }
+        }
+        freeaddrinfo(res);
+        if (fd_ < 0) {
+            error = "osc: cannot listen on " + where;
+            return false;
+        }
+
+        // bursts from a sequencer land while the thread is descheduled
+        int rcvbuf = 1 << 20;
+        setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+        sockaddr_storage bound = {};
+        socklen_t len = sizeof(bound);
+        getsockname(fd_, (sockaddr*)&bound, &len);
+        char service[16] = "";
+        getnameinfo((sockaddr*)&bound, len, nullptr, 0, service,
+                    sizeof(service), NI_NUMERICSERV | NI_DGRAM);
+        port_ = atoi(service);
+        return true;
+    }
+
+    int port() const { return port_; }
+
+    void start(OscQueue& queue) {
+        queue_ = &queue;
+        running_ = true;
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    void stop() {
+        running_ = false;
+        if (thread_.joinable()) thread_.join();
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+    }
+
+    bool running() const { return running_; }
+
+    uint64_t packets() const { return packets_; }
+    uint64_t events() const { return events_; }
+    uint64_t dropped() const { return dropped_; }     // queue full
+    uint64_t malformed() const { return malformed_; } // or not understood
+
+private:
+    void run() {
+        pollfd p = { fd_, POLLIN, 0 };
+        while (running_) {
+            if (::poll(&p, 1, 100) <= 0) continue;
+            int n = receive();
+            int64_t now = monotonicNs();
+            for (int i = 0; i < n; i++)
+                handle(buffers_[i], sizes_[i], now);
+        }
+    }
+
+    int receive() {
+#ifdef __linux__
+        for (int i = 0; i < BATCH; i++) {
+            iov_[i] = { buffers_[i], MAX_PACKET };
+            msgs_[i] = {};
+            msgs_[i].msg_hdr.msg_iov = &iov_[i];
+            msgs_[i].msg_hdr.msg_iovlen = 1;
+        }
+        int n = recvmmsg(fd_, msgs_, BATCH, MSG_DONTWAIT, nullptr);
+        for (int i = 0; i < n; i++)
+            sizes_[i] = msgs_[i].msg_len;
+        return std::max(n, 0);
+#else
+        int n = 0;
+        for (ssize_t got; n < BATCH
+             && (got = recv(fd_, buffers_[n], MAX_PACKET, MSG_DONTWAIT)) >= 0; n++)
+            sizes_[n] = size_t(got);
+        return n;
+#endif
+    }
+
+    void handle(const uint8_t* data, size_t size, int64_t now) {
+        packets_.fetch_add(1, std::memory_order_relaxed);
+        bool understood = true;
+        bool ok = parseOsc(data, size, [&](const OscMessage& m) {
+            OscEvent e;
+            if (!oscToEvent(m, e)) {
+                understood = false;
+                return;
+            }
+            e.timeNs = now;
+            if (queue_->push(e)) events_.fetch_add(1, std::memory_order_relaxed);
+            else dropped_.fetch_add(1, std::memory_order_relaxed);
+        });
+        if (!ok || !understood)
+            malformed_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    int fd_ = -1;
+    int port_ = 0;
+    OscQueue* queue_ = nullptr;
+    std::atomic<bool> running_{ false };
+    std::thread thread_;
+
+    alignas(64) uint8_t buffers_[BATCH][MAX_PACKET];
+    size_t sizes_[BATCH] = {};
+#ifdef __linux__
+    iovec iov_[BATCH];
+    mmsghdr msgs_[BATCH];
+#endif
+
+    std::atomic<uint64_t> packets_{ 0 }, events_{ 0 }, dropped_{ 0 }, malformed_{ 0 };
+};
+
+// =====================
+// OSC WRITING
+// =====================
+// Builds one message into a caller's buffer, for senders and the bench:
+// oscWrite(buf, sizeof(buf), "/piano", "if", 3, 0.8f). Returns the
+// packet size, 0 if it does not fit. Only 'i' and 'f' arguments.
+inline size_t oscPutString(uint8_t* out, size_t cap, size_t at, const char* s) {
+    size_t n = strlen(s), padded = (n + 4) & ~size_t(3);
+    if (at + padded > cap) return 0;
+    memcpy(out + at, s, n);
+    memset(out + at + n, 0, padded - n);
+    return at + padded;
+}
+
+inline size_t oscWrite(uint8_t* out, size_t cap, const char* address,
+                       const char* types, ...) {
+    char tags[16] = ",";
+    strncat(tags, types, sizeof(tags) - 2);
+    size_t at = oscPutString(out, cap, 0, address);
+    if (at) at = oscPutString(out, cap, at, tags);
+    if (!at) return 0;
+
+    va_list args;
+    va_start(args, types);
+    for (const char* t = types; *t; t++) {
+        uint32_t bits;
+        if (*t == 'i') {
+            bits = uint32_t(va_arg(args, int));
+        } else {
+            float f = float(va_arg(args, double));
+            memcpy(&bits, &f, 4);
+        }
+        if (at + 4 > cap) {
+            at = 0;
+            break;
+        }
+        out[at] = uint8_t(bits >> 24);
+        out[at + 1] = uint8_t(bits >> 16);
+        out[at + 2] = uint8_t(bits >> 8);
+        out[at + 3] = uint8_t(bits);
+        at += 4;
+    }
+    va_end(args);
+    return at;
+}
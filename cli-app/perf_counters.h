@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// =====================
+// HARDWARE COUNTERS
+// =====================
+// Thin wrapper over perf_event_open for the benchmarks. Counts cycles,
+// instructions, cache references/misses and L1D read misses for the
+// calling thread. open() fails on non-Linux hosts or when
+// kernel.perf_event_paranoid forbids it; callers should then report
+// timing only.
+struct PerfCounters {
+    enum { CYCLES, INSTRUCTIONS, CACHE_REFS, CACHE_MISSES, L1D_MISSES, COUNT };
+
+    int fd[COUNT];
+    uint64_t value[COUNT];
+    bool opened = false;
+
+    PerfCounters() {
+        for (int i = 0; i < COUNT; i++) {
+            fd[i] = -1;
+            value[i] = 0;
+        }
+    }
+
+    ~PerfCounters() { close(); }
+
+    bool open() {
+#ifdef __linux__
+        const uint32_t types[COUNT] = {
+            PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+            PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+            PERF_TYPE_HW_CACHE
+        };
+        const uint64_t configs[COUNT] = {
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_REFERENCES,
+            PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_CACHE_L1D
+                | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+        };
+
+        for (int i = 0; i < COUNT; i++) {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = types[i];
+            attr.config = configs[i];
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+
+            fd[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+            if (fd[i] < 0) {
+                close();
+                return false;
+            }
+        }
+        opened = true;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void close() {
+#ifdef __linux__
+        for (int i = 0; i < COUNT; i++) {
+            if (fd[i] >= 0) ::close(fd[i]);
+            fd[i] = -1;
+        }
+#endif
+    }
+
+    // values stay readable after close()
+    bool available() const { return opened; }
+
+    void start() {
+#ifdef __linux__
+        for (int i = 0; i < COUNT; i++) {
+            if (fd[i] < 0) continue;
+            ioctl(fd[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    void stop() {
+#ifdef __linux__
+        for (int i = 0; i < COUNT; i++) {
+            if (fd[i] < 0) continue;
+            ioctl(fd[i], PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd[i], &value[i], sizeof(value[i])) != sizeof(value[i]))
+                value[i] = 0;
+        }
+#endif
+    }
+};
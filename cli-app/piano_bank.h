@@ -0,0 +1,416 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "arena.h"
+#include "dsp.h"
+#include "samples.h"
+#include "scheduler.h"
+#include "voices.h"
+
+// =====================
+// PIANO BANK
+// =====================
+// Pre-rendered piano notes: `layers` velocity layers per key, each with
+// `variants` round-robin renders that differ only in the hammer noise.
+// Layer l is rendered at velocity (l + 1) / layers, so a single layer is
+// the old full-velocity bank.
+//
+// Every note is rendered twice, dampers down and pedal down; the mixer
+// crossfades between the two as the pedal moves and applies note-off
+// itself (see VoiceBank), so neither ever re-renders the bank.
+//
+// A lazy bank renders only the first PIANO_HEAD frames of each note up
+// front, enough for the attack. Once a note is played, an Urgent job on
+// the bank's Scheduler renders the rest, due when its voice would run
+// dry, and stays PIANO_AHEAD frames ahead of where the voice has got
+// to. Time since the last trigger stands in for the voice's position,
+// so the mixer is not involved. A finished note stays rendered; memory
+// and work follow what is played. With `warm` set, Background jobs fill
+// in every note as well, giving way to the Urgent ones.
+//
+// One bank covers every octave: play() takes a pitch step for the
+// voices (see VoiceBank), and a pitched voice's render-ahead keeps pace
+// with the faster or slower reading. Rendering at another octaveScale
+// is still there for callers that want each register's own timbre.
+constexpr int MAX_LAYERS   = 8;
+constexpr int MAX_VARIANTS = 4;
+
+constexpr int PIANO_HEAD  = 8 * 512;    // ~93 ms, rendered eagerly
+constexpr int PIANO_AHEAD = 32 * 512;   // ~370 ms of margin
+constexpr int PIANO_CHUNK = 512;        // worker step, whole BFP blocks
+constexpr auto PIANO_IDLE = std::chrono::milliseconds(2);
+
+struct PianoBank {
+    int layers = 1;
+    int variants = 1;
+    SampleFormat format = SampleFormat::Float32;
+    PianoModel model = PianoModel::Waveguide;
+    bool lazy = false;
+    bool warm = false;  // lazy: render everything in the background too
+    std::vector<SampleBuffer> notes;  // [key][layer][variant][damped, pedal]
+
+    int nextVariant[MAX_PIANO_NOTES] = {};  // round-robin cursor, caller's thread
+    Arena scratch;  // a note's worth per render thread, kept across renders
+
+    // lazy banks only, one per note
+    std::unique_ptr<std::atomic<int>[]> ready;        // frames written
+    std::unique_ptr<std::atomic<int64_t>[]> playedAt; // last trigger, ns; 0 = never
+    std::unique_ptr<std::atomic<float>[]> playedStep; // ... and its pitch step
+
+    PianoBank() = default;
+    PianoBank(const PianoBank&) = delete;
+    PianoBank& operator=(const PianoBank&) = delete;
+    ~PianoBank() { stopAhead(); }
+
+    // lazily on `renderOn`'s workers if given, else all in render()
+    void allocate(SampleFormat fmt, int numLayers, int numVariants,
+                  Scheduler* renderOn = nullptr) {
+        stopAhead();
+        format = fmt;
+        layers = std::clamp(numLayers, 1, MAX_LAYERS);
+        variants = std::clamp(numVariants, 1, MAX_VARIANTS);
+        scheduler = renderOn;
+        lazy = renderOn != nullptr;
+
+        notes.assign(MAX_PIANO_NOTES * layers * variants * 2, SampleBuffer());
+        for (SampleBuffer& s : notes)
+            s.allocate(format, PIANO_N, !lazy);
+        scratch.allocate(renderThreads() * (PIANO_N * sizeof(float) + Arena::ALIGN));
+
+        ready.reset();
+        playedAt.reset();
+        playedStep.reset();
+        streaming.reset();
+        streams.clear();
+        streamAt.clear();
+        if (lazy) {
+            ready.reset(new std::atomic<int>[notes.size()]);
+            playedAt.reset(new std::atomic<int64_t>[notes.size()]);
+            playedStep.reset(new std::atomic<float>[notes.size()]);
+            streaming.reset(new std::atomic<bool>[notes.size()]);
+            for (size_t j = 0; j < notes.size(); j++) {
+                ready[j].store(0);
+                playedAt[j].store(0);
+                playedStep[j].store(1.0f);
+                streaming[j].store(false);
+                notes[j].ready = &ready[j];
+            }
+            streams.resize(notes.size());
+            streamAt.assign(notes.size(), 0);
+        }
+    }
+
+    int renderThreads() const {
+        return std::clamp(int(std::thread::hardware_concurrency()), 1,
+                          int(notes.size()));
+    }
+
+    SampleBuffer& at(int key, int layer, int variant, bool pedal = false) {
+        return notes[((key * layers + layer) * variants + variant) * 2 + pedal];
+    }
+
+    double layerVelocity(int layer) const {
+        return double(layer + 1) / layers;
+    }
+
+    size_t bytes() const {
+        size_t total = 0;
+        for (const SampleBuffer& s : notes)
+            total += s.bytes();
+        return total;
+    }
+
+    // what has been written so far: all of bytes() unless lazy
+    size_t renderedBytes() const {
+        if (!lazy) return bytes();
+        size_t total = 0;
+        for (size_t j = 0; j < notes.size(); j++)
+            total += size_t(double(notes[j].bytes()) * ready[j].load() / PIANO_N);
+        return total;
+    }
+
+    int notesComplete() const {
+        int n = 0;
+        for (size_t j = 0; j < notes.size(); j++)
+            n += !lazy || ready[j].load() == PIANO_N;
+        return n;
+    }
+
+    // Renders every (key, layer, variant, pedal) on all cores, all of it
+    // or, lazily, the first PIANO_HEAD frames before handing the rest to
+    // the scheduler. Each job has its own noise seed and each thread its
+    // own slice of `scratch`, so the result does not depend on the
+    // thread count, nor on how much was rendered in one go; both tails
+    // of a note share the seed.
+    void render(double octaveScale) {
+        stopAhead();
+        scale = octaveScale;
+
+        renderJobs();
+        if (!lazy) return;
+
+        aheadRunning = true;
+        liveJobs += 1;
+        scheduler->spawn(watch(), Priority::Urgent);
+        if (warm) {
+            for (int w = 0; w < scheduler->threads(); w++) {
+                liveJobs += 1;
+                scheduler->spawn(warmNotes(w, scheduler->threads()),
+                                 Priority::Background);
+            }
+        }
+    }
+
+    // Ends this bank's jobs and waits for them; before the bank changes
+    // and before its scheduler goes away.
+    void stopAhead() {
+        aheadRunning = false;
+        while (liveJobs.load() > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        for (std::unique_ptr<PianoNote>& note : streams)
+            note.reset();
+    }
+
+    // Starts `key` at `velocity`, `step` times the rendered pitch.
+    // Between two layers the voices of both are started with
+    // complementary gains; below the softest layer it is scaled down.
+    // Each key owns two voice sources, SRC + 2*key (+1).
+    void play(TriggerQueue& q, int sourceBase, int key, double velocity,
+              float step = 1.0f) {
+        int variant = nextVariant[key];
+        nextVariant[key] = (variant + 1) % variants;
+        playVariant(q, sourceBase, key, velocity, variant, step);
+    }
+
+    // play() for a caller with its own round-robin cursor (another
+    // thread). `q` is anything with push(const Trigger&).
+    template <typename Queue>
+    void playVariant(Queue& q, int sourceBase, int key, double velocity,
+                     int variant, float step = 1.0f) {
+        variant %= variants;
+        double pos = velocity * layers - 1.0;  // fractional layer index
+        int lo = std::clamp(int(floor(pos)), 0, layers - 1);
+        int hi = std::min(lo + 1, layers - 1);
+        double w = std::clamp(pos - lo, 0.0, 1.0);
+
+        int src = sourceBase + 2 * key;
+
+        auto start = [&](int layer, double gain, int source) {
+            if (lazy) {
+                int64_t now = nowNs();
+                int j = int(&at(key, layer, variant) - notes.data());
+                playedStep[j].store(step, std::memory_order_relaxed);
+                playedStep[j + 1].store(step, std::memory_order_relaxed);
+                playedAt[j].store(now, std::memory_order_relaxed);
+                playedAt[j + 1].store(now, std::memory_order_relaxed);
+            }
+            q.push({ &at(key, layer, variant), float(gain), source,
+                     &at(key, layer, variant, true), Trigger::Start, step });
+        };
+
+        if (pos < 0.0) {
+            start(0, velocity / layerVelocity(0), src);
+            q.push({ nullptr, 0.0f, src + 1 });
+        } else if (hi == lo || w == 0.0) {
+            start(lo, 1.0, src);
+            q.push({ nullptr, 0.0f, src + 1 });
+        } else {
+            start(lo, 1.0 - w, src);
+            start(hi, w, src + 1);
+        }
+    }
+
+    // Note-off for `key`: both of its voices damp unless the pedal holds
+    // them.
+    template <typename Queue>
+    static void release(Queue& q, int sourceBase, int key) {
+        int src = sourceBase + 2 * key;
+        q.push({ nullptr, 0.0f, src, nullptr, Trigger::Release });
+        q.push({ nullptr, 0.0f, src + 1, nullptr, Trigger::Release });
+    }
+
+private:
+    double scale = 1.0;  // octave of the last render()
+    Scheduler* scheduler = nullptr;
+    std::atomic<bool> aheadRunning{ false };
+    std::atomic<int> liveJobs{ 0 };
+
+    // per note: a job is writing it, and the PianoNote (the writer's
+    // only) and how far that has got
+    std::unique_ptr<std::atomic<bool>[]> streaming;
+    std::vector<std::unique_ptr<PianoNote>> streams;
+    std::vector<int> streamAt;
+
+    static int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void startNote(PianoNote& note, int j) const {
+        int variant = (j / 2) % variants;
+        int layer = (j / (2 * variants)) % layers;
+        int key = j / (2 * variants * layers);
+        note.start(pianoFreqs[key] * scale, j % 2, layerVelocity(layer),
+                   uint32_t(key * MAX_VARIANTS + variant), model);
+    }
+
+    // render()'s parallel part
+    void renderJobs() {
+        int jobs = int(notes.size());
+        int threads = renderThreads();
+        std::atomic<int> next(0);
+        ArenaScope scope(scratch);
+
+        auto worker = [&](float* buffer) {
+            std::unique_ptr<PianoNote> note =
+                lazy ? std::make_unique<PianoNote>() : nullptr;
+            for (int j = next++; j < jobs; j = next++) {
+                if (lazy) {
+                    // the buffer is reused as it is, so pages the last
+                    // render's tail faulted in stay mapped and locked;
+                    // that tail no longer counts, and is written over
+                    // as the new one is rendered ahead
+                    ready[j].store(0, std::memory_order_release);
+                    startNote(*note, j);
+                    note->render(buffer, PIANO_HEAD);
+                    notes[j].encode(buffer, 0, PIANO_HEAD);
+                    playedAt[j].store(0);
+                    ready[j].store(PIANO_HEAD, std::memory_order_release);
+                    continue;
+                }
+
+                bool pedal = j % 2;
+                int variant = (j / 2) % variants;
+                int layer = (j / (2 * variants)) % layers;
+                int key = j / (2 * variants * layers);
+
+                generatePianoNote(
+                    buffer,
+                    pianoFreqs[key] * scale,
+                    pedal,
+                    layerVelocity(layer),
+                    uint32_t(key * MAX_VARIANTS + variant),
+                    model
+                );
+                notes[j].encode(buffer);
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; t++)
+            pool.emplace_back(worker, scratch.alloc<float>(PIANO_N));
+        worker(scratch.alloc<float>(PIANO_N));
+        for (std::thread& t : pool)
+            t.join();
+    }
+
+    // where note `j`'s voice would be now, and when it catches up with
+    // `have` frames; a pitched voice reads `step` frames per frame, and
+    // the resampler up to a kernel's reach beyond that
+    int playhead(int j, int64_t now) const {
+        float step = playedStep[j].load(std::memory_order_relaxed);
+        int reach = step == 1.0f ? 0 : pitchKernel(step).half();
+        return int(double(now - playedAt[j].load(std::memory_order_relaxed))
+                   * SAMPLE_RATE * step / 1e9) + reach;
+    }
+
+    JobClock::time_point runsDry(int j, int have) const {
+        float step = playedStep[j].load(std::memory_order_relaxed);
+        int reach = step == 1.0f ? 0 : pitchKernel(step).half();
+        return JobClock::time_point(std::chrono::nanoseconds(
+            playedAt[j].load(std::memory_order_relaxed)
+            + int64_t(double(have - reach) * 1e9 / (SAMPLE_RATE * step))));
+    }
+
+    // Every PIANO_IDLE: a streamNote job for each played note that is
+    // running short and has none.
+    Job watch() {
+        while (aheadRunning) {
+            int64_t now = nowNs();
+            for (int j = 0; j < int(notes.size()); j++) {
+                int have = ready[j].load(std::memory_order_relaxed);
+                if (!playedAt[j].load(std::memory_order_relaxed)
+                    || have == PIANO_N
+                    || have - playhead(j, now) >= PIANO_AHEAD
+                    || streaming[j].exchange(true))
+                    continue;
+                liveJobs += 1;
+                scheduler->spawn(streamNote(j), Priority::Urgent,
+                                 runsDry(j, have));
+            }
+            co_await scheduler->sleepFor(PIANO_IDLE, Priority::Urgent);
+        }
+        liveJobs -= 1;
+    }
+
+    // One PIANO_CHUNK more of note `j`, whose `streaming` flag the
+    // caller holds; returns the frames now written. The first time, the
+    // PianoNote renders the head again to get there.
+    int renderChunk(int j, float* buffer) {
+        std::unique_ptr<PianoNote>& note = streams[j];
+        int have = ready[j].load(std::memory_order_relaxed);
+        if (!note) {
+            note = std::make_unique<PianoNote>();
+            startNote(*note, j);
+            streamAt[j] = 0;
+        }
+        for (int n; streamAt[j] < have; streamAt[j] += n) {
+            n = std::min(PIANO_CHUNK, have - streamAt[j]);
+            note->render(buffer, n);
+        }
+
+        int n = std::min(PIANO_CHUNK, PIANO_N - have);
+        note->render(buffer, n);
+        notes[j].encode(buffer, have, n);
+        streamAt[j] += n;
+        ready[j].store(have + n, std::memory_order_release);
+        if (have + n == PIANO_N) note.reset();
+        return have + n;
+    }
+
+    // Renders played note `j` until it is PIANO_AHEAD ahead of its voice
+    // (or complete), due each chunk when the voice would run dry.
+    Job streamNote(int j) {
+        float buffer[PIANO_CHUNK];
+        while (aheadRunning) {
+            int have = renderChunk(j, buffer);
+            if (have == PIANO_N || have - playhead(j, nowNs()) >= PIANO_AHEAD)
+                break;
+            co_await scheduler->yield(Priority::Urgent, runsDry(j, have));
+        }
+        streaming[j] = false;
+        liveJobs -= 1;
+    }
+
+    // Warming, one of `of` jobs: completes every note j = first (mod
+    // of), a chunk at a time. A note is only held for the chunk, so a
+    // played one goes to its Urgent job at the next watch(); notes held
+    // by one are passed over and come round again.
+    Job warmNotes(int first, int of) {
+        float buffer[PIANO_CHUNK];
+        for (bool left = true; left && aheadRunning; ) {
+            left = false;
+            for (int j = first; j < int(notes.size()) && aheadRunning; j += of) {
+                while (ready[j].load(std::memory_order_relaxed) < PIANO_N) {
+                    if (streaming[j].exchange(true)) {
+                        left = true;
+                        break;
+                    }
+                    renderChunk(j, buffer);
+                    streaming[j] = false;
+                    co_await scheduler->yield(Priority::Background);
+                    if (!aheadRunning) break;
+                }
+            }
+        }
+        liveJobs -= 1;
+    }
+};
@@ -0,0 +1,641 @@
+// Render regression harness: renders every instrument, the drum and
+// piano generators, a threaded piano bank build and the engine
+// sequences with fixed seeds, and checks them against the goldens.
+// Before the renders it runs a few checks of the input paths that make
+// no sound of their own (key mapping, OSC parsing).
+//
+//   cmake --build build --target regress   (see CMakeLists.txt), or
+//   g++ -O2 -std=c++20 -pthread regress.cpp dsp.cpp -o regress
+//   ./regress                  check everything against goldens/
+//   ./regress piano bass       only cases whose name contains a word
+//   ./regress --update         re-record goldens after an intended change
+//   ./regress --tolerance 2    accept up to 2 LSB (16-bit) of difference
+//
+// goldens/golden.txt (committed) holds a hash of the exact float output
+// per case; a matching hash is a bit-exact pass. The WAVs next to it are
+// written by --update but not committed: where one exists, a hash
+// mismatch is still a pass if every sample is within the tolerance, and
+// without one it is a failure. So a tolerance needs the WAVs recorded
+// first, on a known-good tree; an explicit --tolerance refuses to run
+// without them rather than quietly checking for exact equality.
+// Exits non-zero on any failure.
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "arena.h"
+#include "dsp.h"
+#include "input.h"
+#include "osc.h"
+#include "voices.h"
+#include "piano_bank.h"
+#include "rt.h"
+#include "wav.h"
+#include "instruments/kick.h"
+#include "instruments/registry.h"
+
+// =====================
+// CASES
+// =====================
+struct Case {
+    std::string name;
+    std::function<void(std::vector<float>&)> render;
+    std::function<void()> prepare = nullptr;  // untimed setup, optional
+};
+
+void renderInstrument(const InstrumentInfo& info, int note, float velocity,
+                      double seconds, std::vector<float>& out) {
+    int n = int(seconds * SAMPLE_RATE);
+    out.assign(n, 0.0f);
+
+    std::unique_ptr<Instrument> inst = info.create();
+    inst->prepare(SAMPLE_RATE, MAX_BLOCK);
+    NoAllocScope noAlloc;
+    inst->noteOn(note, velocity);
+    for (int done = 0; done < n; done += MAX_BLOCK)
+        inst->renderBlock(out.data() + done, std::min(MAX_BLOCK, n - done));
+}
+
+void renderPianoNote(double freq, double velocity, uint32_t seed,
+                     PianoModel model, std::vector<float>& out) {
+    out.assign(PIANO_N, 0.0f);
+    generatePianoNote(out.data(), freq, false, velocity, seed, model);
+}
+
+// Every sample of a bank built on all cores, decoded, key by key; the
+// damped or the pedal tails.
+void renderBank(SampleFormat format, int layers, int variants, bool pedal,
+                std::vector<float>& out) {
+    PianoBank bank;
+    bank.allocate(format, layers, variants);
+    bank.render(1.0);
+
+    out.clear();
+    for (int key = 0; key < MAX_PIANO_NOTES; key++)
+        for (int layer = 0; layer < bank.layers; layer++)
+            for (int variant = 0; variant < bank.variants; variant++) {
+                const SampleBuffer& s = bank.at(key, layer, variant, pedal);
+                for (int i = 0; i < s.length; i++)
+                    out.push_back(s.at(i));
+            }
+}
+
+// =====================
+// ENGINE SEQUENCES
+// =====================
+// The live engine's signal path (voice bank, live kick, one hosted
+// instrument, tanh) driven by a timed event list. Events are applied at
+// the start of the 256-frame callback they fall in, and the callback
+// runs under FTZ/DAZ, both as in synth.
+constexpr int SEQ_PERIOD = 256;
+
+struct SeqEvent {
+    double time;    // seconds
+    char what;      // 'k' kick, 's' snare, 'h' hat, 'p' piano, 'n' note,
+                    // 'P' sustain pedal; 'c' closed and 'o' open hat,
+                    // which choke each other
+    int key;        // piano key or MIDI note
+    float velocity; // 0 = note off / pedal up
+};
+
+// the sequences' samples, built once outside the timing
+struct SeqSamples {
+    SampleBuffer snare, hat, openHat;
+    PianoBank piano;
+};
+
+SeqSamples& seqSamples() {
+    static SeqSamples s;
+    if (s.piano.notes.empty()) {
+        static float snareData[SNARE_N], hatData[HAT_N];
+        generateSnare(snareData);
+        generateHiHat(hatData);
+        s.snare.allocate(SampleFormat::Float32, SNARE_N);
+        s.snare.encode(snareData);
+        s.hat.allocate(SampleFormat::Float32, HAT_N);
+        s.hat.encode(hatData);
+        s.openHat.allocate(SampleFormat::Float32, OPEN_HAT_N);
+        generateOpenHiHat(s.openHat.f32.data());
+
+        s.piano.allocate(SampleFormat::Int16, 2, 2);
+        s.piano.render(1.0);
+    }
+    return s;
+}
+
+void renderSequence(std::vector<SeqEvent> events, double seconds,
+                    const char* instrument, std::vector<float>& out) {
+    std::stable_sort(events.begin(), events.end(),
+                     [](const SeqEvent& a, const SeqEvent& b) {
+                         return a.time < b.time;
+                     });
+
+    SeqSamples& samples = seqSamples();
+    const SampleBuffer& snare = samples.snare;
+    const SampleBuffer& hat = samples.hat;
+    const SampleBuffer& openHat = samples.openHat;
+    PianoBank& piano = samples.piano;
+    std::fill(std::begin(piano.nextVariant), std::end(piano.nextVariant), 0);
+
+    auto voices = std::make_unique<VoiceBank>();
+    TriggerQueue triggers;
+    auto kick = std::make_unique<Kick>();
+    kick->prepare(SAMPLE_RATE, MAX_BLOCK);
+    std::unique_ptr<Instrument> hosted = findInstrument(instrument)->create();
+    hosted->prepare(SAMPLE_RATE, MAX_BLOCK);
+
+    int n = int(seconds * SAMPLE_RATE);
+    out.assign(n, 0.0f);
+    size_t next = 0;
+
+    NoDenormals noDenormals;
+    for (int done = 0; done < n; done += SEQ_PERIOD) {
+        NoAllocScope noAlloc;  // one block of the synth's callback
+        int frames = std::min(SEQ_PERIOD, n - done);
+
+        for (; next < events.size()
+               && events[next].time * SAMPLE_RATE < done + frames; next++) {
+            const SeqEvent& e = events[next];
+            if (e.what == 'k') kick->noteOn(36, e.velocity);
+            if (e.what == 's') triggers.push({ &snare, e.velocity, 0 });
+            if (e.what == 'h') triggers.push({ &hat, e.velocity, 1 });
+            if (e.what == 'c' || e.what == 'o')
+                triggers.push({ e.what == 'c' ? &hat : &openHat, e.velocity,
+                                e.what == 'c' ? 1 : 3, nullptr,
+                                Trigger::Start, 1.0f, 1 });
+            if (e.what == 'p') {
+                if (e.velocity > 0.0f) piano.play(triggers, 2, e.key, e.velocity);
+                else piano.release(triggers, 2, e.key);
+            }
+            if (e.what == 'P')
+                triggers.push({ nullptr, e.velocity, 0, nullptr, Trigger::Pedal });
+            if (e.what == 'n') {
+                if (e.velocity > 0.0f) hosted->noteOn(e.key, e.velocity);
+                else hosted->noteOff(e.key);
+            }
+        }
+
+        Trigger t;
+        while (triggers.pop(t))
+            startVoice(*voices, t);
+
+        float mix[SEQ_PERIOD] = {};
+        mixVoices(*voices, mix, frames);
+        kick->renderBlock(mix, frames);
+        hosted->renderBlock(mix, frames);
+        for (int i = 0; i < frames; i++)
+            out[done + i] = tanh(mix[i] * 0.8f);
+    }
+}
+
+// two bars of a 120 bpm beat with ghost notes
+std::vector<SeqEvent> drumPattern() {
+    std::vector<SeqEvent> e;
+    for (int step = 0; step < 32; step++) {
+        double t = step * 0.125;
+        if (step % 8 == 0 || step == 27) e.push_back({ t, 'k', 0, 1.0f });
+        if (step % 8 == 4) e.push_back({ t, 's', 0, 1.0f });
+        if (step % 8 == 7) e.push_back({ t, 's', 0, 0.3f });
+        e.push_back({ t, 'h', 0, step % 2 ? 0.5f : 0.9f });
+    }
+    return e;
+}
+
+// open hats on the off-beats, each cut by the next closed one, a
+// closed-hat roll and an open hat left to ring out
+std::vector<SeqEvent> hatChokes() {
+    std::vector<SeqEvent> e;
+    for (int step = 0; step < 16; step++) {
+        double t = step * 0.125;
+        e.push_back({ t, step % 2 ? 'o' : 'c', 0, step % 4 == 0 ? 1.0f : 0.7f });
+        if (step % 8 == 0) e.push_back({ t, 'k', 0, 1.0f });
+    }
+    for (int i = 0; i < 8; i++)
+        e.push_back({ 2.0 + i / 32.0, 'c', 0, 0.4f + 0.075f * i });
+    e.push_back({ 2.25, 'o', 0, 1.0f });
+    return e;
+}
+
+// piano chords across the velocity layers over a held, re-articulated
+// bass line
+std::vector<SeqEvent> pianoAndBass() {
+    std::vector<SeqEvent> e;
+    const int chords[4][3] = { { 0, 4, 7 }, { 5, 9, 12 }, { 7, 11, 14 },
+                               { 0, 4, 7 } };
+    const int bass[4] = { 36, 41, 43, 36 };
+    for (int bar = 0; bar < 4; bar++) {
+        double t = bar * 0.75;
+        for (int k = 0; k < 3; k++)
+            e.push_back({ t + k * 0.01, 'p', chords[bar][k],
+                          0.25f + 0.25f * bar });
+        e.push_back({ t, 'n', bass[bar], 0.9f });
+        e.push_back({ t + 0.5, 'n', bass[bar], 0.0f });
+    }
+    return e;
+}
+
+// a phrase played detached, then legato under the pedal, the pedal
+// lifted over a held chord and a last note damped straight away
+std::vector<SeqEvent> pianoPedal() {
+    std::vector<SeqEvent> e;
+    const int melody[8] = { 12, 14, 16, 17, 19, 17, 16, 14 };
+    for (int i = 0; i < 8; i++) {
+        double t = i * 0.25;
+        e.push_back({ t, 'p', melody[i], 0.7f });
+        e.push_back({ t + 0.15, 'p', melody[i], 0.0f });
+    }
+    e.push_back({ 1.0, 'P', 0, 1.0f });
+    for (int k : { 0, 4, 7 }) {
+        e.push_back({ 2.0, 'p', k, 0.6f });
+        e.push_back({ 3.2, 'p', k, 0.0f });
+    }
+    e.push_back({ 2.6, 'P', 0, 0.0f });
+    e.push_back({ 3.5, 'p', 12, 0.9f });
+    e.push_back({ 3.6, 'p', 12, 0.0f });
+    return e;
+}
+
+std::vector<Case> allCases() {
+    std::vector<Case> cases;
+
+    for (const InstrumentInfo& info : INSTRUMENTS)
+        cases.push_back({ std::string("inst-") + info.name,
+                          [&info](std::vector<float>& out) {
+            renderInstrument(info, info.defaultNote, 1.0f,
+                             info.defaultSeconds, out);
+        } });
+
+    cases.push_back({ "drum-snare", [](std::vector<float>& out) {
+        out.assign(SNARE_N, 0.0f);
+        generateSnare(out.data());
+    } });
+    cases.push_back({ "drum-kick", [](std::vector<float>& out) {
+        out.assign(KICK_N, 0.0f);
+        generateKick(out.data());
+    } });
+    cases.push_back({ "drum-hihat", [](std::vector<float>& out) {
+        out.assign(HAT_N, 0.0f);
+        generateHiHat(out.data());
+    } });
+    cases.push_back({ "drum-openhat", [](std::vector<float>& out) {
+        out.assign(OPEN_HAT_N, 0.0f);
+        generateOpenHiHat(out.data());
+    } });
+
+    struct PianoCase {
+        const char* name;
+        double freq, velocity;
+        uint32_t seed;
+        PianoModel model;
+    };
+    const PianoCase pianos[] = {
+        { "piano-wg-c2",        65.41, 1.0, 0, PianoModel::Waveguide },
+        { "piano-wg-c4",       261.63, 1.0, 0, PianoModel::Waveguide },
+        { "piano-wg-c4-soft",  261.63, 0.4, 1, PianoModel::Waveguide },
+        { "piano-wg-g5",       783.99, 0.7, 2, PianoModel::Waveguide },
+        { "piano-add-c4",      261.63, 1.0, 0, PianoModel::Additive },
+        { "piano-add-g5-soft", 783.99, 0.4, 3, PianoModel::Additive },
+    };
+    for (const PianoCase& p : pianos)
+        cases.push_back({ p.name, [p](std::vector<float>& out) {
+            renderPianoNote(p.freq, p.velocity, p.seed, p.model, out);
+        } });
+
+    cases.push_back({ "bank-i16-1x2", [](std::vector<float>& out) {
+        renderBank(SampleFormat::Int16, 1, 2, false, out);
+    } });
+    cases.push_back({ "bank-bfp8-2x1", [](std::vector<float>& out) {
+        renderBank(SampleFormat::BlockFloat8, 2, 1, false, out);
+    } });
+    cases.push_back({ "bank-i16-pedal-1x1", [](std::vector<float>& out) {
+        renderBank(SampleFormat::Int16, 1, 1, true, out);
+    } });
+
+    cases.push_back({ "seq-drums", [](std::vector<float>& out) {
+        renderSequence(drumPattern(), 4.5, "bass", out);
+    }, [] { seqSamples(); } });
+    cases.push_back({ "seq-hat-chokes", [](std::vector<float>& out) {
+        renderSequence(hatChokes(), 3.0, "bass", out);
+    }, [] { seqSamples(); } });
+    cases.push_back({ "seq-piano-bass", [](std::vector<float>& out) {
+        renderSequence(pianoAndBass(), 4.0, "bass", out);
+    }, [] { seqSamples(); } });
+    cases.push_back({ "seq-piano-pedal", [](std::vector<float>& out) {
+        renderSequence(pianoPedal(), 5.0, "bass", out);
+    }, [] { seqSamples(); } });
+
+    return cases;
+}
+
+// =====================
+// CHECKS
+// =====================
+// Pass/fail, no goldens; selected by the same filters as the cases.
+struct Check {
+    std::string name;
+    std::function<bool()> pass;
+};
+
+// one message through the packet parser and oscToEvent
+template <typename... Args>
+bool oscEvent(OscEvent& e, const char* address, const char* types, Args... args) {
+    uint8_t packet[64];
+    size_t n = oscWrite(packet, sizeof(packet), address, types, args...);
+    bool accepted = false;
+    parseOsc(packet, n, [&](const OscMessage& m) { accepted = oscToEvent(m, e); });
+    return accepted;
+}
+
+std::vector<Check> allChecks() {
+    std::vector<Check> checks;
+
+#ifdef __linux__
+    // evdev must type what the terminal would: the octave keys are the
+    // arrow escapes' last byte, the controllers - = , .
+    checks.push_back({ "input-evdev-keys", [] {
+        const struct { int code; bool shift; char want; } keys[] = {
+            { KEY_A, false, 'a' }, { KEY_A, true, 'A' },
+            { KEY_SPACE, false, ' ' }, { KEY_ENTER, false, '\n' },
+            { KEY_LEFT, false, 'D' }, { KEY_RIGHT, false, 'C' },
+            { KEY_LEFT, true, 'D' }, { KEY_RIGHT, true, 'C' },
+            { KEY_MINUS, false, '-' }, { KEY_EQUAL, false, '=' },
+            { KEY_COMMA, false, ',' }, { KEY_DOT, false, '.' },
+            { KEY_ESC, false, 0 },
+        };
+        for (const auto& k : keys)
+            if (evdevChar(k.code, k.shift) != k.want) return false;
+        return true;
+    } });
+#endif
+
+    // the network is untrusted: nothing non-finite or out of range
+    // gets through, and what does has its velocity in [0, 1]
+    checks.push_back({ "osc-ranges", [] {
+        OscEvent e;
+        bool pass = oscEvent(e, "/piano", "if", 3, 0.8f)
+                 && e.index == 3 && e.value == 0.8f;
+        pass &= oscEvent(e, "/piano", "ff", 3.0f, 5.0f) && e.value == 1.0f;
+        pass &= oscEvent(e, "/piano", "if", 3, -2.0f) && e.value == 0.0f;
+        pass &= oscEvent(e, "/drum/kick", "f", 1e30f) && e.value == 1.0f;
+        pass &= oscEvent(e, "/note", "i", 127) && e.index == 127 && e.value == 1.0f;
+        pass &= oscEvent(e, "/cc", "if", 74, 0.25f) && e.value == 0.25f;
+
+        pass &= !oscEvent(e, "/piano", "f", NAN);
+        pass &= !oscEvent(e, "/piano", "i", -1);
+        pass &= !oscEvent(e, "/piano", "i", MAX_PIANO_NOTES);
+        pass &= !oscEvent(e, "/piano", "f", 1e9f);
+        pass &= !oscEvent(e, "/piano", "if", 3, NAN);
+        pass &= !oscEvent(e, "/note", "i", 128);
+        pass &= !oscEvent(e, "/note", "f", -INFINITY);
+        pass &= !oscEvent(e, "/note", "if", 60, INFINITY);
+        pass &= !oscEvent(e, "/cc", "if", 300, 0.5f);
+        pass &= !oscEvent(e, "/cc", "if", 74, NAN);
+        pass &= !oscEvent(e, "/drum/snare", "f", NAN);
+        pass &= !oscEvent(e, "/pedal", "f", NAN);
+        return pass;
+    } });
+
+    return checks;
+}
+
+// =====================
+// GOLDENS
+// =====================
+struct Golden {
+    size_t frames = 0;
+    uint64_t hash = 0;
+    double peak = 0.0, rms = 0.0;
+};
+
+// FNV-1a over the float bit patterns: any change at all shows
+uint64_t hashSamples(const std::vector<float>& x) {
+    uint64_t h = 1469598103934665603ull;
+    for (float f : x) {
+        uint32_t bits;
+        memcpy(&bits, &f, 4);
+        for (int b = 0; b < 4; b++) {
+            h ^= (bits >> (8 * b)) & 0xff;
+            h *= 1099511628211ull;
+        }
+    }
+    return h;
+}
+
+Golden describe(const std::vector<float>& x) {
+    Golden g;
+    g.frames = x.size();
+    g.hash = hashSamples(x);
+    double sum = 0.0;
+    for (float f : x) {
+        g.peak = std::max(g.peak, double(fabsf(f)));
+        sum += double(f) * f;
+    }
+    g.rms = x.empty() ? 0.0 : sqrt(sum / x.size());
+    return g;
+}
+
+std::map<std::string, Golden> loadGoldens(const std::string& path) {
+    std::map<std::string, Golden> goldens;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream in(line);
+        std::string name;
+        Golden g;
+        in >> name >> g.frames >> std::hex >> g.hash >> std::dec
+           >> g.peak >> g.rms;
+        if (in) goldens[name] = g;
+    }
+    return goldens;
+}
+
+bool saveGoldens(const std::string& path,
+                 const std::map<std::string, Golden>& goldens) {
+    std::ofstream file(path);
+    file << "# regress goldens: name frames fnv1a64(float bits) peak rms\n"
+         << "# regenerate with ./regress --update\n";
+    for (const auto& [name, g] : goldens)
+        file << name << " " << g.frames << " " << std::hex
+             << std::setw(16) << std::setfill('0') << g.hash << std::dec
+             << std::setfill(' ') << std::setprecision(6) << " " << g.peak
+             << " " << g.rms << "\n";
+    return bool(file);
+}
+
+// largest difference in 16-bit LSBs, quantized the way writeWav does
+int maxLsbDiff(const std::vector<float>& a, const std::vector<float>& b) {
+    if (a.size() != b.size()) return -1;
+    int worst = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        int qa = int(lrintf(std::clamp(a[i], -1.0f, 1.0f) * 32767.0f));
+        int qb = int(lrintf(std::clamp(b[i], -1.0f, 1.0f) * 32767.0f));
+        worst = std::max(worst, abs(qa - qb));
+    }
+    return worst;
+}
+
+// =====================
+// MAIN
+// =====================
+void usage() {
+    std::cerr << "usage: regress [--update] [--tolerance LSB] [--dir DIR] "
+                 "[filter...]\n";
+}
+
+int main(int argc, char** argv) {
+    bool update = false;
+    bool toleranceGiven = false;
+    int tolerance = 1;
+    std::string dir = "goldens";
+    std::vector<std::string> filters;
+
+    for (int i = 1; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (strcmp(argv[i], "--update") == 0) {
+            update = true;
+        } else if (value && strcmp(argv[i], "--tolerance") == 0) {
+            tolerance = std::max(0, atoi(value));
+            toleranceGiven = true;
+            i++;
+        } else if (value && strcmp(argv[i], "--dir") == 0) {
+            dir = value;
+            i++;
+        } else if (argv[i][0] == '-') {
+            usage();
+            return 1;
+        } else {
+            filters.push_back(argv[i]);
+        }
+    }
+
+    const std::string goldenPath = dir + "/golden.txt";
+    std::map<std::string, Golden> goldens = loadGoldens(goldenPath);
+    if (goldens.empty() && !update) {
+        std::cerr << "no goldens in " << goldenPath
+                  << " (run from cli-app/, or --update)\n";
+        return 1;
+    }
+
+    auto selected = [&](const std::string& name) {
+        if (filters.empty()) return true;
+        for (const std::string& f : filters)
+            if (name.find(f) != std::string::npos) return true;
+        return false;
+    };
+
+    if (toleranceGiven && !update) {
+        int missing = 0, cases = 0;
+        for (const Case& c : allCases()) {
+            if (!selected(c.name)) continue;
+            cases++;
+            missing += !std::ifstream(dir + "/" + c.name + ".wav").good();
+        }
+        if (missing) {
+            std::cerr << "--tolerance: " << missing << " of " << cases
+                      << " case(s) have no reference WAV in " << dir
+                      << "/ to compare against (record them with --update "
+                         "on a known-good tree first)\n";
+            return 1;
+        }
+    }
+
+    std::cout << std::left << std::setw(22) << "case"
+              << std::right << std::setw(10) << "seconds"
+              << std::setw(11) << "render ms"
+              << std::setw(11) << "x realtime"
+              << "  result\n";
+
+    int failures = 0;
+    std::vector<float> out;
+
+    if (!update) {
+        for (const Check& c : allChecks()) {
+            if (!selected(c.name)) continue;
+
+            bool pass = c.pass();
+            failures += !pass;
+            std::cout << std::left << std::setw(56) << c.name
+                      << (pass ? "ok" : "FAIL") << "\n";
+        }
+    }
+
+    for (const Case& c : allCases()) {
+        if (!selected(c.name)) continue;
+
+        if (c.prepare) c.prepare();
+        auto t0 = std::chrono::steady_clock::now();
+        c.render(out);
+        auto t1 = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        double seconds = double(out.size()) / SAMPLE_RATE;
+
+        std::cout << std::left << std::setw(22) << c.name << std::right
+                  << std::fixed << std::setprecision(2)
+                  << std::setw(10) << seconds
+                  << std::setw(11) << ms
+                  << std::setprecision(0)
+                  << std::setw(10) << seconds * 1000.0 / ms << "x  ";
+
+        Golden now = describe(out);
+        std::string wavPath = dir + "/" + c.name + ".wav";
+
+        if (update) {
+            goldens[c.name] = now;
+            writeWav(wavPath.c_str(), out.data(), int(out.size()),
+                     SAMPLE_RATE);
+            std::cout << "recorded\n";
+            continue;
+        }
+
+        auto it = goldens.find(c.name);
+        if (it == goldens.end()) {
+            std::cout << "FAIL (no golden)\n";
+            failures++;
+        } else if (it->second.hash == now.hash
+                   && it->second.frames == now.frames) {
+            std::cout << "exact\n";
+        } else {
+            std::vector<float> ref;
+            int diff = readWav(wavPath.c_str(), ref) ? maxLsbDiff(out, ref)
+                                                     : -2;
+            if (diff >= 0 && diff <= tolerance) {
+                std::cout << "ok, within " << diff << " LSB\n";
+            } else {
+                failures++;
+                std::cout << std::setprecision(6) << "FAIL (";
+                if (diff == -2) std::cout << "hash differs, no " << wavPath
+                                          << " for a tolerance";
+                else if (diff == -1) std::cout << "length " << now.frames
+                                               << " vs " << it->second.frames;
+                else std::cout << diff << " LSB > " << tolerance;
+                std::cout << "; peak " << now.peak << " vs "
+                          << it->second.peak << ", rms " << now.rms
+                          << " vs " << it->second.rms << ")\n";
+            }
+        }
+    }
+
+    if (update) {
+        if (!saveGoldens(goldenPath, goldens)) {
+            std::cerr << "cannot write " << goldenPath << "\n";
+            return 1;
+        }
+        std::cout << "wrote " << goldenPath << "\n";
+        return 0;
+    }
+
+    std::cout << (failures ? "FAILED: " : "all passed")
+              << (failures ? std::to_string(failures) + " case(s)" : "")
+              << "\n";
+    return failures ? 1 : 0;
+}
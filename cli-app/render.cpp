@@ -0,0 +1,202 @@
+// Offline renderer for registered instruments and scores.
+//
+//   cmake --build build --target render   (see CMakeLists.txt), or
+//   g++ -O2 -std=c++20 -pthread render.cpp -o render
+//   ./render --list
+//   ./render kick-fixed                  -> kick-fixed.wav
+//   ./render bass --note 40 --seconds 1 -o bass-e2.wav
+//   ./render --score scores/groove.txt --loop 40 --verify
+//
+// Instruments are driven exactly as the live engine drives them: one
+// noteOn, then renderBlock in MAX_BLOCK chunks. Scores (see score.h) are
+// rendered on all cores by cutting each track's timeline where it is
+// silent; --verify renders once more on one thread and checks the two
+// are bit-identical.
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "arena.h"
+#include "dsp.h"
+#include "score.h"
+#include "wav.h"
+#include "instruments/registry.h"
+
+void usage() {
+    std::cerr <<
+        "usage: render --list\n"
+        "       render <instrument> [--note N] [--velocity V] "
+        "[--seconds S] [-o out.wav]\n"
+        "       render --score FILE [--loop N] [--threads N] "
+        "[--segment S] [--verify] [-o out.wav]\n";
+}
+
+void listInstruments() {
+    for (const InstrumentInfo& info : INSTRUMENTS)
+        std::cout << std::left << std::setw(16) << info.name
+                  << info.description << "\n";
+}
+
+double millisSince(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - t0).count();
+}
+
+int renderScoreFile(int argc, char** argv) {
+    std::string scorePath = argv[2];
+    std::string outPath = "score.wav";
+    int loops = 1;
+    int threads = std::max(1, int(std::thread::hardware_concurrency()));
+    double segment = 5.0;
+    bool verify = false;
+
+    for (int i = 3; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (strcmp(argv[i], "--verify") == 0) {
+            verify = true;
+            continue;
+        }
+        if (!value) {
+            usage();
+            return 1;
+        }
+
+        if (strcmp(argv[i], "--loop") == 0) loops = std::max(1, atoi(value));
+        else if (strcmp(argv[i], "--threads") == 0) threads = std::max(1, atoi(value));
+        else if (strcmp(argv[i], "--segment") == 0) segment = atof(value);
+        else if (strcmp(argv[i], "-o") == 0) outPath = value;
+        else {
+            usage();
+            return 1;
+        }
+        i++;
+    }
+
+    Score score;
+    std::string error;
+    if (!loadScore(scorePath, score, error)) {
+        std::cerr << scorePath << ": " << error << "\n";
+        return 1;
+    }
+    loopScore(score, loops);
+
+    std::vector<float> mix;
+    auto t0 = std::chrono::steady_clock::now();
+    RenderStats stats = renderScore(score, threads, secondsToFrames(segment), mix);
+    double ms = millisSince(t0);
+
+    double seconds = double(score.frames) / SAMPLE_RATE;
+    std::cout << std::fixed << std::setprecision(1)
+              << scorePath << ": " << score.tracks.size() << " tracks, "
+              << score.events.size() << " events, " << seconds << " s\n"
+              << threads << " thread(s): " << ms << " ms ("
+              << std::setprecision(0) << seconds * 1000.0 / ms
+              << "x realtime), " << stats.jobs << " jobs, " << stats.handoffs
+              << " handoffs, " << stats.fallbacks << " re-rendered, "
+              << std::setprecision(1)
+              << 100.0 * stats.rendered / (double(score.frames) * score.tracks.size())
+              << "% of track frames rendered\n";
+
+    if (verify) {
+        std::vector<float> serial;
+        t0 = std::chrono::steady_clock::now();
+        renderScore(score, 1, 0, serial);
+        double serialMs = millisSince(t0);
+
+        bool same = serial.size() == mix.size()
+            && memcmp(serial.data(), mix.data(), mix.size() * sizeof(float)) == 0;
+        std::cout << "1 thread: " << serialMs << " ms, speedup "
+                  << std::setprecision(2) << serialMs / ms << "x, "
+                  << (same ? "bit-identical" : "MISMATCH") << "\n";
+        if (!same) return 1;
+    }
+
+    if (!writeWav(outPath.c_str(), mix.data(), int(mix.size()), SAMPLE_RATE)) {
+        std::cerr << "cannot write " << outPath << "\n";
+        return 1;
+    }
+    std::cout << "Wrote " << outPath << "\n";
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+    if (strcmp(argv[1], "--list") == 0) {
+        listInstruments();
+        return 0;
+    }
+    if (strcmp(argv[1], "--score") == 0) {
+        if (argc < 3) {
+            usage();
+            return 1;
+        }
+        return renderScoreFile(argc, argv);
+    }
+
+    const InstrumentInfo* info = findInstrument(argv[1]);
+    if (!info) {
+        std::cerr << "unknown instrument: " << argv[1] << "\n";
+        listInstruments();
+        return 1;
+    }
+
+    int note = info->defaultNote;
+    float velocity = 1.0f;
+    double seconds = info->defaultSeconds;
+    std::string outPath = std::string(info->name) + ".wav";
+
+    for (int i = 2; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) {
+            usage();
+            return 1;
+        }
+
+        if (strcmp(argv[i], "--note") == 0) note = atoi(value);
+        else if (strcmp(argv[i], "--velocity") == 0) velocity = (float)atof(value);
+        else if (strcmp(argv[i], "--seconds") == 0) seconds = atof(value);
+        else if (strcmp(argv[i], "-o") == 0) outPath = value;
+        else {
+            usage();
+            return 1;
+        }
+        i++;
+    }
+
+    int numSamples = int(seconds * SAMPLE_RATE);
+    std::vector<float> out(numSamples, 0.0f);
+
+    std::unique_ptr<Instrument> inst = info->create();
+    inst->prepare(SAMPLE_RATE, MAX_BLOCK);
+    inst->noteOn(note, velocity);
+
+    auto t0 = std::chrono::steady_clock::now();
+    {
+        NoAllocScope noAlloc;
+        for (int done = 0; done < numSamples; done += MAX_BLOCK)
+            inst->renderBlock(out.data() + done,
+                              std::min(MAX_BLOCK, numSamples - done));
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    if (!writeWav(outPath.c_str(), out.data(), numSamples, SAMPLE_RATE)) {
+        std::cerr << "cannot write " << outPath << "\n";
+        return 1;
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    int blocks = (numSamples + MAX_BLOCK - 1) / MAX_BLOCK;
+    std::cout << "Wrote " << outPath << " (" << info->name << ", note "
+              << note << ", " << seconds << " s) in " << std::fixed
+              << std::setprecision(2) << ms << " ms, "
+              << std::setprecision(1) << ms * 1000.0 / blocks << " us/block\n";
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// =====================
+// RESAMPLING
+// =====================
+// Band-limited reading of a sampled sound at another rate, `step` input
+// frames per output frame: below 1 it plays lower, above 1 higher, and
+// a rate conversion is the same thing with step = from / to.
+//
+// The filter is a Kaiser-windowed sinc stored polyphase: one row of
+// taps per 1/RESAMPLE_PHASES of an input frame, interpolated linearly
+// between neighbouring rows (skipped when the position falls on a row,
+// as it always does for octave steps). Reading faster than 1 needs the
+// cutoff lowered to the output's Nyquist, or everything above it folds
+// back; the kernel is built `stretch` times wider and lower for that,
+// so its taps per output frame grow with the step.
+constexpr int RESAMPLE_HALF      = 32;     // taps each side at stretch 1
+constexpr int RESAMPLE_PHASES    = 256;
+constexpr double RESAMPLE_CUTOFF = 0.90;   // of Nyquist, at stretch 1
+constexpr double RESAMPLE_BETA   = 8.0;    // Kaiser: ~80 dB stopband
+
+// x . h over `taps` floats, a multiple of 8; with `h1`, also x . h1
+inline float dotTaps(const float* x, const float* h, int taps) {
+#if defined(__AVX__)
+    __m256 a = _mm256_setzero_ps();
+    for (int q = 0; q < taps; q += 8)
+        a = _mm256_add_ps(a, _mm256_mul_ps(_mm256_loadu_ps(x + q),
+                                           _mm256_loadu_ps(h + q)));
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+#elif defined(__SSE2__)
+    __m128 a = _mm_setzero_ps(), b = _mm_setzero_ps();
+    for (int q = 0; q < taps; q += 8) {
+        a = _mm_add_ps(a, _mm_mul_ps(_mm_loadu_ps(x + q), _mm_loadu_ps(h + q)));
+        b = _mm_add_ps(b, _mm_mul_ps(_mm_loadu_ps(x + q + 4),
+                                     _mm_loadu_ps(h + q + 4)));
+    }
+    __m128 s = _mm_add_ps(a, b);
+#endif
+#if defined(__SSE2__)
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+#else
+    float sum = 0.0f;
+    for (int q = 0; q < taps; q++)
+        sum += x[q] * h[q];
+    return sum;
+#endif
+}
+
+inline void dotTaps(const float* x, const float* h0, const float* h1, int taps,
+                    float& y0, float& y1) {
+#if defined(__AVX__)
+    __m256 a = _mm256_setzero_ps(), b = _mm256_setzero_ps();
+    for (int q = 0; q < taps; q += 8) {
+        __m256 v = _mm256_loadu_ps(x + q);
+        a = _mm256_add_ps(a, _mm256_mul_ps(v, _mm256_loadu_ps(h0 + q)));
+        b = _mm256_add_ps(b, _mm256_mul_ps(v, _mm256_loadu_ps(h1 + q)));
+    }
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+    __m128 t = _mm_add_ps(_mm256_castps256_ps128(b), _mm256_extractf128_ps(b, 1));
+#elif defined(__SSE2__)
+    __m128 s = _mm_setzero_ps(), t = _mm_setzero_ps();
+    for (int q = 0; q < taps; q += 4) {
+        __m128 v = _mm_loadu_ps(x + q);
+        s = _mm_add_ps(s, _mm_mul_ps(v, _mm_loadu_ps(h0 + q)));
+        t = _mm_add_ps(t, _mm_mul_ps(v, _mm_loadu_ps(h1 + q)));
+    }
+#endif
+#if defined(__SSE2__)
+    // both horizontal sums at once: [s0+s2, t0+t2, s1+s3, t1+t3]
+    __m128 u = _mm_add_ps(_mm_unpacklo_ps(s, t), _mm_unpackhi_ps(s, t));
+    u = _mm_add_ps(u, _mm_movehl_ps(u, u));
+    y0 = _mm_cvtss_f32(u);
+    y1 = _mm_cvtss_f32(_mm_shuffle_ps(u, u, 1));
+#else
+    y0 = y1 = 0.0f;
+    for (int q = 0; q < taps; q++) {
+        y0 += x[q] * h0[q];
+        y1 += x[q] * h1[q];
+    }
+#endif
+}
+
+class ResampleKernel {
+public:
+    // for steps up to `stretch` (>= 1); a step below 1 needs no more
+    // than stretch 1
+    explicit ResampleKernel(double stretch = 1.0)
+        : stretch_(std::max(1.0, stretch)),
+          half_(int(ceil(RESAMPLE_HALF * stretch_))),
+          taps_((2 * half_ + 7) / 8 * 8),
+          table_(size_t(RESAMPLE_PHASES + 1) * taps_, 0.0f) {
+        double cutoff = RESAMPLE_CUTOFF / stretch_;
+        double norm = besselI0(RESAMPLE_BETA);
+        std::vector<double> row(taps_);
+        for (int p = 0; p <= RESAMPLE_PHASES; p++) {
+            double frac = double(p) / RESAMPLE_PHASES;
+            double sum = 0.0;
+            for (int q = 0; q < 2 * half_; q++) {
+                double x = q - half_ + 1 - frac;   // input frame - position
+                double r = x / (half_ + 1);
+                double window = besselI0(RESAMPLE_BETA * sqrt(std::max(0.0, 1.0 - r * r)))
+                              / norm;
+                double arg = M_PI * cutoff * x;
+                row[q] = cutoff * (arg == 0.0 ? 1.0 : sin(arg) / arg) * window;
+                sum += row[q];
+            }
+            // unity gain at DC in every phase
+            for (int q = 0; q < 2 * half_; q++)
+                table_[size_t(p) * taps_ + q] = float(row[q] / sum);
+        }
+    }
+
+    double stretch() const { return stretch_; }
+    int half() const { return half_; }    // input frames before / after
+    int taps() const { return taps_; }
+
+    // Adds `n` output frames, gain ramped (see mixSamples), read from
+    // `in` at input positions t, t + step, ...; in[i] is input frame i,
+    // which must be there for i in [floor(t) - half() + 1,
+    // floor(t + (n - 1) * step) + half()] (and taps() - 2 * half()
+    // frames more, which the padding taps multiply by zero).
+    void mix(const float* in, double t, double step, int n,
+             float gain, float* out, float gainStep = 0.0f) const {
+        for (int j = 0; j < n; j++) {
+            double at = t + j * step;
+            double whole = floor(at);
+            double phase = (at - whole) * RESAMPLE_PHASES;
+            int p = int(phase);
+            float a = float(phase - p);
+
+            const float* x = in + int(whole) - half_ + 1;
+            const float* h = table_.data() + size_t(p) * taps_;
+            float y;
+            if (a == 0.0f) {
+                y = dotTaps(x, h, taps_);
+            } else {
+                float y1;
+                dotTaps(x, h, h + taps_, taps_, y, y1);
+                y += a * (y1 - y);
+            }
+            out[j] += y * (gain + j * gainStep);
+        }
+    }
+
+private:
+    static double besselI0(double x) {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; term > 1e-12 * sum; k++) {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    double stretch_;
+    int half_;
+    int taps_;
+    std::vector<float> table_;  // [RESAMPLE_PHASES + 1][taps_]
+};
+
+// =====================
+// OFFLINE
+// =====================
+// `in` at `fromRate` as `toRate`, whole (loading a sample, not live).
+inline std::vector<float> resample(const std::vector<float>& in,
+                                   int fromRate, int toRate) {
+    if (fromRate == toRate || in.empty()) return in;
+
+    double step = double(fromRate) / toRate;
+    ResampleKernel kernel(step);
+    int pad = kernel.taps();
+    std::vector<float> padded(in.size() + 2 * size_t(pad), 0.0f);
+    std::copy(in.begin(), in.end(), padded.begin() + pad);
+
+    std::vector<float> out(size_t(ceil(in.size() / step)), 0.0f);
+    kernel.mix(padded.data() + pad, 0.0, step, int(out.size()), 1.0f, out.data());
+    return out;
+}
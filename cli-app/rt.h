@@ -0,0 +1,220 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <string>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// =====================
+// REAL-TIME HARDENING
+// =====================
+// What the engine can do about latency the OS adds behind its back:
+//
+//   lockMemory()      mlockall, so sample banks are never paged out
+//   prefault()        touches every page of a buffer before playback
+//   NoDenormals       flush-to-zero / denormals-are-zero for a scope;
+//                     decaying envelopes and resonator tails otherwise
+//                     end in denormals, which cost ~100 cycles per op
+//   setRealtime()     SCHED_FIFO for the calling (audio) thread
+//
+// Each step can fail without privileges (RLIMIT_MEMLOCK, RLIMIT_RTPRIO);
+// RtReport records what was applied so the host can say so.
+struct RtReport {
+    bool memoryLocked = false;
+    size_t prefaultedBytes = 0;
+    std::atomic<bool> denormalsOff{ false };  // set from the audio thread
+    std::atomic<bool> realtime{ false };      // likewise
+    std::atomic<int> priority{ 0 };
+
+    void print(std::ostream& os) const {
+        os << "rt: memory " << (memoryLocked ? "locked" : "NOT locked")
+           << ", " << prefaultedBytes / 1024 << " KiB prefaulted"
+           << ", denormals " << (denormalsOff ? "flushed" : "NOT flushed")
+           << ", scheduling ";
+        if (realtime) os << "SCHED_FIFO " << priority;
+        else os << "normal";
+        os << "\n";
+    }
+};
+
+// Locks what is mapped now. Not MCL_FUTURE: under a small
+// RLIMIT_MEMLOCK that makes later mmaps (thread stacks for the piano
+// bank rebuild) fail outright, so call this once everything the
+// callback reads is allocated. `onFault` (Linux) locks each page as it
+// is first touched instead of faulting everything in now, for buffers
+// that are written later (a lazy PianoBank).
+inline bool lockMemory(bool onFault = false) {
+#if defined(MCL_ONFAULT)
+    return mlockall(MCL_CURRENT | (onFault ? MCL_ONFAULT : 0)) == 0;
+#elif defined(__unix__) || defined(__APPLE__)
+    (void)onFault;
+    return mlockall(MCL_CURRENT) == 0;
+#else
+    return false;
+#endif
+}
+
+// Reads one byte per page so the first touch happens now, not in the
+// callback. Returns the bytes covered.
+inline size_t prefault(const void* data, size_t bytes) {
+    static const size_t page = [] {
+#if defined(__unix__) || defined(__APPLE__)
+        long p = sysconf(_SC_PAGESIZE);
+        return p > 0 ? size_t(p) : size_t(4096);
+#else
+        return size_t(4096);
+#endif
+    }();
+
+    const volatile unsigned char* p = (const volatile unsigned char*)data;
+    for (size_t i = 0; i < bytes; i += page)
+        (void)p[i];
+    if (bytes) (void)p[bytes - 1];
+    return bytes;
+}
+
+// Touches 64 KiB of the calling thread's stack; call once on the audio
+// thread so deep calls in later callbacks do not fault.
+inline void prefaultStack() {
+    constexpr size_t STACK_BYTES = 64 * 1024;
+    volatile unsigned char stack[STACK_BYTES];
+    for (size_t i = 0; i < STACK_BYTES; i += 1024)
+        stack[i] = 0;
+    (void)stack[0];
+}
+
+// FTZ/DAZ for the current thread while in scope (when `enable`); the
+// previous mode is restored on exit so the host's thread is left as it
+// was.
+class NoDenormals {
+public:
+    explicit NoDenormals(bool enable = true) {
+        if (!enable) return;
+#if defined(__SSE__)
+        saved_ = _mm_getcsr();
+        _mm_setcsr(saved_ | 0x8040);  // FTZ (bit 15) | DAZ (bit 6)
+#elif defined(__aarch64__)
+        uint64_t fpcr;
+        asm volatile("mrs %0, fpcr" : "=r"(fpcr));
+        saved_ = fpcr;
+        asm volatile("msr fpcr, %0" : : "r"(fpcr | (1ull << 24)));  // FZ
+#endif
+        enabled_ = true;
+    }
+
+    ~NoDenormals() {
+        if (!enabled_) return;
+#if defined(__SSE__)
+        _mm_setcsr(unsigned(saved_));
+#elif defined(__aarch64__)
+        asm volatile("msr fpcr, %0" : : "r"(saved_));
+#endif
+    }
+
+    NoDenormals(const NoDenormals&) = delete;
+    NoDenormals& operator=(const NoDenormals&) = delete;
+
+    static bool supported() {
+#if defined(__SSE__) || defined(__aarch64__)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+private:
+    uint64_t saved_ = 0;
+    bool enabled_ = false;
+};
+
+// SCHED_FIFO at `priority` (1..99) for the calling thread.
+inline bool setRealtime(int priority) {
+#if defined(__unix__) || defined(__APPLE__)
+    sched_param sp;
+    std::memset(&sp, 0, sizeof(sp));
+    sp.sched_priority = priority;
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp) == 0;
+#else
+    (void)priority;
+    return false;
+#endif
+}
+
+// =====================
+// CALLBACK TIMING
+// =====================
+// Lock-free histogram of callback durations, written by the audio
+// thread and read by anyone. Bucket b holds [2^b, 2^(b+1)) us.
+struct TimingHistogram {
+    static constexpr int BUCKETS = 16;
+
+    std::atomic<uint32_t> count[BUCKETS] = {};
+    std::atomic<uint32_t> overBudget{ 0 };
+    std::atomic<uint64_t> maxNs{ 0 };
+    std::atomic<uint64_t> total{ 0 };
+    std::atomic<uint64_t> sumNs{ 0 };
+
+    void record(uint64_t ns, uint64_t budgetNs) {
+        uint64_t us = ns / 1000;
+        int b = 0;
+        while (b < BUCKETS - 1 && (us >> (b + 1)) != 0)
+            b++;
+        count[b].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sumNs.fetch_add(ns, std::memory_order_relaxed);
+        if (ns > budgetNs)
+            overBudget.fetch_add(1, std::memory_order_relaxed);
+        if (ns > maxNs.load(std::memory_order_relaxed))
+            maxNs.store(ns, std::memory_order_relaxed);
+    }
+
+    void reset() {
+        for (auto& c : count) c = 0;
+        overBudget = 0;
+        maxNs = 0;
+        total = 0;
+        sumNs = 0;
+    }
+
+    double meanUs() const {
+        return sumNs.load() / 1000.0 / std::max<uint64_t>(1, total.load());
+    }
+
+    // budgetUs < 0: each record() had its own budget, a deadline
+    void print(std::ostream& os, double budgetUs,
+               const char* what = "callbacks") const {
+        uint64_t n = std::max<uint64_t>(1, total.load());
+        os << std::fixed << std::setprecision(1)
+           << "  " << what << " " << total << ", max " << maxNs / 1000.0
+           << " us, ";
+        if (budgetUs < 0.0) os << "past their deadline: ";
+        else os << "over the " << budgetUs << " us budget: ";
+        os << overBudget << "\n";
+
+        int first = 0, last = BUCKETS - 1;
+        while (first < last && count[first] == 0) first++;
+        while (last > first && count[last] == 0) last--;
+        for (int b = first; b <= last; b++) {
+            double share = 100.0 * count[b] / n;
+            os << "  " << std::setw(6) << (b ? 1u << b : 0u) << "-"
+               << std::left << std::setw(6) << (2u << b) << std::right
+               << "us " << std::setw(6) << share << "% "
+               << std::string(size_t(share / 2.0 + 0.5), '#') << "\n";
+        }
+    }
+};
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// =====================
+// SAMPLE STORAGE
+// =====================
+// Pre-rendered sounds can be kept as plain floats, as 16-bit PCM, or as
+// 8-bit block floating point (one float scale per BFP_BLOCK samples).
+// Storage is sized once by allocate(); encode() overwrites it in place
+// so a buffer can be re-rendered without reallocating under the mixer.
+//
+// A buffer can also be filled while it plays (see PianoBank): allocate
+// it unzeroed, so pages cost nothing until written, and point `ready`
+// at the count of frames written so far. The mixer reads no further.
+enum class SampleFormat {
+    Float32,
+    Int16,
+    BlockFloat8
+};
+
+constexpr int BFP_BLOCK = 32;
+
+inline const char* formatName(SampleFormat f) {
+    switch (f) {
+        case SampleFormat::Float32:     return "f32";
+        case SampleFormat::Int16:       return "i16";
+        case SampleFormat::BlockFloat8: return "bfp8";
+    }
+    return "?";
+}
+
+inline bool parseFormat(const char* s, SampleFormat& f) {
+    if (strcmp(s, "f32") == 0)  { f = SampleFormat::Float32;     return true; }
+    if (strcmp(s, "i16") == 0)  { f = SampleFormat::Int16;       return true; }
+    if (strcmp(s, "bfp8") == 0) { f = SampleFormat::BlockFloat8; return true; }
+    return false;
+}
+
+// std::allocator, except that resize() leaves new elements as they
+// are: for a large buffer that is fresh, untouched pages
+template <typename T>
+struct UninitAllocator : std::allocator<T> {
+    template <typename U>
+    struct rebind { using other = UninitAllocator<U>; };
+
+    UninitAllocator() = default;
+    template <typename U>
+    UninitAllocator(const UninitAllocator<U>&) noexcept {}
+
+    template <typename U>
+    void construct(U* p) noexcept {}
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+        ::new ((void*)p) U(std::forward<Args>(args)...);
+    }
+};
+
+template <typename T>
+using SampleVector = std::vector<T, UninitAllocator<T>>;
+
+struct SampleBuffer {
+    SampleFormat format = SampleFormat::Float32;
+    int length = 0;
+    const std::atomic<int>* ready = nullptr;  // frames written; null: all
+
+    SampleVector<float>   f32;
+    SampleVector<int16_t> i16;
+    SampleVector<int8_t>  m8;
+    SampleVector<float>   blockScale;
+
+    void allocate(SampleFormat fmt, int n, bool zeroed = true) {
+        format = fmt;
+        length = n;
+        f32.clear();
+        i16.clear();
+        m8.clear();
+        blockScale.clear();
+
+        // padded to whole blocks so the decoder never reads short
+        int padded = (n + BFP_BLOCK - 1) / BFP_BLOCK * BFP_BLOCK;
+        switch (fmt) {
+            case SampleFormat::Float32:
+                zeroed ? f32.assign(n, 0.0f) : f32.resize(n);
+                break;
+            case SampleFormat::Int16:
+                zeroed ? i16.assign(n, 0) : i16.resize(n);
+                break;
+            case SampleFormat::BlockFloat8:
+                zeroed ? m8.assign(padded, 0) : m8.resize(padded);
+                zeroed ? blockScale.assign(padded / BFP_BLOCK, 0.0f)
+                       : blockScale.resize(padded / BFP_BLOCK);
+                break;
+        }
+    }
+
+    // `src` holds `length` samples in [-1, 1]
+    void encode(const float* src) { encode(src, 0, length); }
+
+    // frames [from, from + n) only, from `src` holding just those; for
+    // BlockFloat8 `from` must start a block
+    void encode(const float* src, int from, int n) {
+        switch (format) {
+            case SampleFormat::Float32:
+                std::copy(src, src + n, f32.begin() + from);
+                break;
+
+            case SampleFormat::Int16:
+                for (int i = 0; i < n; i++) {
+                    float x = std::clamp(src[i], -1.0f, 1.0f);
+                    i16[from + i] = (int16_t)lrintf(x * 32767.0f);
+                }
+                break;
+
+            case SampleFormat::BlockFloat8:
+                src -= from;
+                for (int start = from; start < from + n; start += BFP_BLOCK) {
+                    int end = std::min(from + n, start + BFP_BLOCK);
+
+                    float peak = 0.0f;
+                    for (int i = start; i < end; i++)
+                        peak = std::max(peak, fabsf(src[i]));
+
+                    float scale = peak / 127.0f;
+                    float inv = peak > 0.0f ? 1.0f / scale : 0.0f;
+                    blockScale[start / BFP_BLOCK] = scale;
+
+                    for (int i = start; i < end; i++)
+                        m8[i] = (int8_t)lrintf(src[i] * inv);
+                }
+                break;
+        }
+    }
+
+    float at(int i) const {
+        switch (format) {
+            case SampleFormat::Float32:     return f32[i];
+            case SampleFormat::Int16:       return i16[i] * (1.0f / 32767.0f);
+            case SampleFormat::BlockFloat8: return m8[i] * blockScale[i / BFP_BLOCK];
+        }
+        return 0.0f;
+    }
+
+    size_t bytes() const {
+        return f32.size() * sizeof(float)
+             + i16.size() * sizeof(int16_t)
+             + m8.size() * sizeof(int8_t)
+             + blockScale.size() * sizeof(float);
+    }
+};
+
+// =====================
+// DECODE + MIX
+// =====================
+// mix[j] += (k + j * step) * decoded src[j], j in [0, n): a gain ramp,
+// which with step = 0 is the plain constant-gain mix.
+inline void mixInt16(const int16_t* src, int n, float k, float* mix,
+                     float step = 0.0f) {
+    int j = 0;
+#if defined(__SSE2__)
+    __m128 vk = _mm_setr_ps(k, k + step, k + 2.0f * step, k + 3.0f * step);
+    __m128 v4 = _mm_set1_ps(4.0f * step);
+    for (; j + 8 <= n; j += 8) {
+        __m128i v  = _mm_loadu_si128((const __m128i*)(src + j));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        __m128 vk2 = _mm_add_ps(vk, v4);
+        __m128 a = _mm_add_ps(_mm_loadu_ps(mix + j),
+                              _mm_mul_ps(_mm_cvtepi32_ps(lo), vk));
+        __m128 b = _mm_add_ps(_mm_loadu_ps(mix + j + 4),
+                              _mm_mul_ps(_mm_cvtepi32_ps(hi), vk2));
+        _mm_storeu_ps(mix + j, a);
+        _mm_storeu_ps(mix + j + 4, b);
+        vk = _mm_add_ps(vk2, v4);
+    }
+#endif
+    for (; j < n; j++)
+        mix[j] += src[j] * (k + j * step);
+}
+
+inline void mixInt8(const int8_t* src, int n, float k, float* mix,
+                    float step = 0.0f) {
+    int j = 0;
+#if defined(__SSE2__)
+    __m128 vk = _mm_setr_ps(k, k + step, k + 2.0f * step, k + 3.0f * step);
+    __m128 v4 = _mm_set1_ps(4.0f * step);
+    for (; j + 8 <= n; j += 8) {
+        __m128i v  = _mm_loadl_epi64((const __m128i*)(src + j));
+        __m128i w  = _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(w, w), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(w, w), 16);
+        __m128 vk2 = _mm_add_ps(vk, v4);
+        __m128 a = _mm_add_ps(_mm_loadu_ps(mix + j),
+                              _mm_mul_ps(_mm_cvtepi32_ps(lo), vk));
+        __m128 b = _mm_add_ps(_mm_loadu_ps(mix + j + 4),
+                              _mm_mul_ps(_mm_cvtepi32_ps(hi), vk2));
+        _mm_storeu_ps(mix + j, a);
+        _mm_storeu_ps(mix + j + 4, b);
+        vk = _mm_add_ps(vk2, v4);
+    }
+#endif
+    for (; j < n; j++)
+        mix[j] += src[j] * (k + j * step);
+}
+
+inline void mixSamples(const SampleBuffer& s, int pos, int n,
+                       float gain, float* mix, float step = 0.0f) {
+    switch (s.format) {
+        case SampleFormat::Float32: {
+            const float* src = s.f32.data() + pos;
+            if (step == 0.0f) {
+                for (int j = 0; j < n; j++)
+                    mix[j] += src[j] * gain;
+            } else {
+                for (int j = 0; j < n; j++)
+                    mix[j] += src[j] * (gain + j * step);
+            }
+            break;
+        }
+
+        case SampleFormat::Int16: {
+            const float k = 1.0f / 32767.0f;
+            mixInt16(s.i16.data() + pos, n, gain * k, mix, step * k);
+            break;
+        }
+
+        case SampleFormat::BlockFloat8: {
+            // walk the range one scale block at a time
+            int end = pos + n;
+            while (pos < end) {
+                int b = pos / BFP_BLOCK;
+                int run = std::min(end, (b + 1) * BFP_BLOCK) - pos;
+                float k = s.blockScale[b];
+                mixInt8(s.m8.data() + pos, run, gain * k, mix, step * k);
+                mix += run;
+                pos += run;
+                gain += run * step;
+            }
+            break;
+        }
+    }
+}
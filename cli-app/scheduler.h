@@ -0,0 +1,332 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rt.h"
+
+// =====================
+// BACKGROUND JOBS
+// =====================
+// Work that must not run on the audio thread and should not block the
+// input thread (render-ahead, bank warming, analysis) runs as a Job: a
+// C++20 coroutine resumed by a small pool of worker threads.
+//
+//   Job render(Scheduler& s, ...) {
+//       while (...) {
+//           ...one chunk...
+//           co_await s.yield(Priority::Urgent, deadline);
+//       }
+//   }
+//   scheduler.spawn(render(scheduler, ...), Priority::Normal);
+//
+// Ready jobs run most urgent priority first, then earliest deadline
+// first. Preemption is cooperative: a job gives up its worker at a
+// co_await, and yield() only suspends when something at least as
+// urgent is waiting, so a long Background job chunked with yields lets
+// Urgent work through within one chunk. A job's priority and deadline
+// are whatever it last yielded with; it can raise or lower them as it
+// goes.
+//
+// Metrics: queue depth per priority (now and peak), how long jobs wait
+// between becoming ready and running (over budget = started after the
+// deadline), and spawn-to-finish times.
+enum class Priority : uint8_t {
+    Urgent,      // a voice will run dry without it (render-ahead)
+    Normal,
+    Background   // nobody is waiting (cache warming)
+};
+
+constexpr int PRIORITIES = 3;
+
+inline const char* priorityName(Priority p) {
+    switch (p) {
+        case Priority::Urgent:     return "urgent";
+        case Priority::Normal:     return "normal";
+        case Priority::Background: return "background";
+    }
+    return "?";
+}
+
+using JobClock = std::chrono::steady_clock;
+constexpr JobClock::time_point NO_DEADLINE = JobClock::time_point::max();
+
+class Scheduler;
+
+class Job {
+public:
+    struct promise_type {
+        Scheduler* scheduler = nullptr;
+        Priority priority = Priority::Normal;
+        JobClock::time_point deadline = NO_DEADLINE;
+        JobClock::time_point spawned;
+        JobClock::time_point readyAt;   // last time it was queued
+
+        Job get_return_object() {
+            return Job(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct Finish {
+            bool await_ready() noexcept { return false; }
+            void await_suspend(std::coroutine_handle<promise_type> h) noexcept;
+            void await_resume() noexcept {}
+        };
+        Finish final_suspend() noexcept { return {}; }
+
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Job(Job&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+    Job(const Job&) = delete;
+    Job& operator=(const Job&) = delete;
+    ~Job() { if (handle) handle.destroy(); }  // never spawned
+
+private:
+    friend class Scheduler;
+    explicit Job(Handle h) : handle(h) {}
+    Handle handle;
+};
+
+class Scheduler {
+public:
+    // 0: one worker per core
+    explicit Scheduler(int threads = 0) {
+        if (threads <= 0)
+            threads = std::max(1, int(std::thread::hardware_concurrency()));
+        for (int t = 0; t < threads; t++)
+            workers.emplace_back(&Scheduler::work, this);
+    }
+
+    // Jobs still queued or asleep are destroyed without running on.
+    ~Scheduler() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& t : workers)
+            t.join();
+        for (std::priority_queue<Entry, std::vector<Entry>, Later>& q : ready)
+            for (; !q.empty(); q.pop())
+                q.top().handle.destroy();
+        for (; !timers.empty(); timers.pop())
+            timers.top().handle.destroy();
+    }
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    void spawn(Job job, Priority priority = Priority::Normal,
+               JobClock::time_point deadline = NO_DEADLINE) {
+        Job::Handle h = std::exchange(job.handle, {});
+        Job::promise_type& p = h.promise();
+        p.scheduler = this;
+        p.spawned = JobClock::now();
+        spawnedJobs.fetch_add(1, std::memory_order_relaxed);
+        enqueue(h, priority, deadline);
+    }
+
+    // co_await: carry on at `priority` / `deadline`, after anything more
+    // urgent that is waiting
+    auto yield(Priority priority, JobClock::time_point deadline = NO_DEADLINE) {
+        struct Awaiter {
+            Scheduler& s;
+            Priority priority;
+            JobClock::time_point deadline;
+
+            bool await_ready() const {
+                for (int p = 0; p <= int(priority); p++)
+                    if (s.depth[p].load(std::memory_order_relaxed) > 0)
+                        return false;
+                // a sleeper that is due only gets queued by a worker
+                return JobClock::now().time_since_epoch().count()
+                     < s.nextTimer.load(std::memory_order_relaxed);
+            }
+            void await_suspend(Job::Handle h) {
+                s.enqueue(h, priority, deadline);
+            }
+            void await_resume() {}
+        };
+        return Awaiter{ *this, priority, deadline };
+    }
+
+    // co_await: resume at `when`, then as `priority`
+    auto sleepUntil(JobClock::time_point when,
+                    Priority priority = Priority::Normal) {
+        struct Awaiter {
+            Scheduler& s;
+            JobClock::time_point when;
+            Priority priority;
+
+            bool await_ready() const { return JobClock::now() >= when; }
+            void await_suspend(Job::Handle h) {
+                h.promise().priority = priority;
+                h.promise().deadline = NO_DEADLINE;
+                {
+                    std::lock_guard<std::mutex> lock(s.mutex);
+                    s.timers.push({ h, when, 0 });
+                    s.nextTimer.store(s.timers.top().when.time_since_epoch().count(),
+                                      std::memory_order_relaxed);
+                }
+                s.wake.notify_one();
+            }
+            void await_resume() {}
+        };
+        return Awaiter{ *this, when, priority };
+    }
+
+    template <typename Duration>
+    auto sleepFor(Duration d, Priority priority = Priority::Normal) {
+        return sleepUntil(JobClock::now() + d, priority);
+    }
+
+    int threads() const { return int(workers.size()); }
+    int queued(Priority p) const { return depth[int(p)].load(); }
+    int peakQueued(Priority p) const { return peakDepth[int(p)].load(); }
+    uint64_t spawned() const { return spawnedJobs.load(); }
+    uint64_t finished() const { return finishedJobs.load(); }
+
+    // ready -> running, over budget = started after its deadline
+    const TimingHistogram& waits(Priority p) const { return waitTimes[int(p)]; }
+    // spawn -> finish, over budget = finished after its last deadline
+    const TimingHistogram& lifetimes(Priority p) const { return jobTimes[int(p)]; }
+
+    void print(std::ostream& os) const {
+        os << "jobs: " << threads() << " worker(s), " << spawned()
+           << " spawned, " << finished() << " finished\n";
+        for (int p = 0; p < PRIORITIES; p++) {
+            if (waitTimes[p].total == 0) continue;
+            os << priorityName(Priority(p)) << ": queued " << depth[p]
+               << " (peak " << peakDepth[p] << "); ready -> running:\n";
+            waitTimes[p].print(os, -1.0, "resumes");
+            os << "  spawn -> finish:\n";
+            jobTimes[p].print(os, -1.0, "jobs");
+        }
+    }
+
+private:
+    friend struct Job::promise_type::Finish;
+
+    struct Entry {
+        Job::Handle handle;
+        JobClock::time_point when;  // deadline, or wake-up time for timers
+        uint64_t order;             // FIFO among equals
+    };
+
+    struct Later {
+        bool operator()(const Entry& a, const Entry& b) const {
+            return a.when != b.when ? a.when > b.when : a.order > b.order;
+        }
+    };
+
+    static uint64_t nsUntil(JobClock::time_point from, JobClock::time_point to) {
+        if (to == NO_DEADLINE) return UINT64_MAX;
+        if (to <= from) return 0;
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            to - from).count());
+    }
+
+    void enqueue(Job::Handle h, Priority priority,
+                 JobClock::time_point deadline) {
+        Job::promise_type& p = h.promise();
+        p.priority = priority;
+        p.deadline = deadline;
+        p.readyAt = JobClock::now();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pushReady(h);
+        }
+        wake.notify_one();
+    }
+
+    // with `mutex` held
+    void pushReady(Job::Handle h) {
+        int p = int(h.promise().priority);
+        ready[p].push({ h, h.promise().deadline, sequence++ });
+        int d = depth[p].fetch_add(1, std::memory_order_relaxed) + 1;
+        if (d > peakDepth[p].load(std::memory_order_relaxed))
+            peakDepth[p].store(d, std::memory_order_relaxed);
+    }
+
+    void finish(Job::Handle h) {
+        const Job::promise_type& p = h.promise();
+        JobClock::time_point now = JobClock::now();
+        jobTimes[int(p.priority)].record(nsUntil(p.spawned, now),
+                                         nsUntil(p.spawned, p.deadline));
+        finishedJobs.fetch_add(1, std::memory_order_relaxed);
+        h.destroy();
+    }
+
+    void work() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            JobClock::time_point now = JobClock::now();
+            for (; !timers.empty() && timers.top().when <= now; timers.pop()) {
+                Job::Handle h = timers.top().handle;
+                h.promise().readyAt = now;
+                pushReady(h);
+            }
+            nextTimer.store(timers.empty() ? INT64_MAX
+                                           : timers.top().when.time_since_epoch().count(),
+                            std::memory_order_relaxed);
+
+            int p = 0;
+            while (p < PRIORITIES && ready[p].empty()) p++;
+            if (p == PRIORITIES) {
+                if (timers.empty()) wake.wait(lock);
+                else wake.wait_until(lock, timers.top().when);
+                continue;
+            }
+
+            Job::Handle h = ready[p].top().handle;
+            ready[p].pop();
+            depth[p].fetch_sub(1, std::memory_order_relaxed);
+            lock.unlock();
+
+            const Job::promise_type& promise = h.promise();
+            waitTimes[p].record(nsUntil(promise.readyAt, now),
+                                nsUntil(promise.readyAt, promise.deadline));
+            h.resume();
+
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::priority_queue<Entry, std::vector<Entry>, Later> ready[PRIORITIES];
+    std::priority_queue<Entry, std::vector<Entry>, Later> timers;
+    uint64_t sequence = 0;
+    bool stopping = false;
+    std::atomic<int64_t> nextTimer{ INT64_MAX };  // earliest timers.when
+
+    std::atomic<int> depth[PRIORITIES] = {};
+    std::atomic<int> peakDepth[PRIORITIES] = {};
+    std::atomic<uint64_t> spawnedJobs{ 0 };
+    std::atomic<uint64_t> finishedJobs{ 0 };
+    TimingHistogram waitTimes[PRIORITIES];
+    TimingHistogram jobTimes[PRIORITIES];
+
+    std::vector<std::thread> workers;
+};
+
+inline void Job::promise_type::Finish::await_suspend(
+        std::coroutine_handle<promise_type> h) noexcept {
+    h.promise().scheduler->finish(h);
+}
@@ -0,0 +1,316 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "arena.h"
+#include "dsp.h"
+#include "instruments/registry.h"
+
+// =====================
+// SCORE
+// =====================
+// An arrangement for the offline renderer: tracks, each one registered
+// instrument, and timed notes and controller moves on them. Text, one
+// statement per line, `#` starts a comment, times in seconds:
+//
+//   track <name> <instrument> [gain]
+//   <time> <track> <note> <velocity> [length]   length = note-off after
+//   <time> <track> cc <number> <value>
+//   length <seconds>   loop period for --loop (default: the last event)
+//   tail <seconds>     rendered after the end (default 3)
+struct ScoreTrack {
+    std::string name;
+    const InstrumentInfo* info;
+    float gain;
+};
+
+struct ScoreEvent {
+    int64_t frame;
+    int track;
+    int cc;          // -1 for a note
+    int note;
+    float value;     // velocity (0 = note off) or controller value
+};
+
+struct Score {
+    std::vector<ScoreTrack> tracks;
+    std::vector<ScoreEvent> events;  // by frame, file order within one
+    double length = -1.0;
+    double tail = 3.0;
+    int64_t frames = 0;              // everything to render
+};
+
+inline int64_t secondsToFrames(double seconds) {
+    return int64_t(llround(seconds * SAMPLE_RATE));
+}
+
+inline void finishScore(Score& score) {
+    std::stable_sort(score.events.begin(), score.events.end(),
+                     [](const ScoreEvent& a, const ScoreEvent& b) {
+                         return a.frame < b.frame;
+                     });
+    int64_t last = score.events.empty() ? 0 : score.events.back().frame;
+    if (score.length >= 0.0)
+        last = std::max(last, secondsToFrames(score.length));
+    score.frames = last + secondsToFrames(score.tail);
+}
+
+// False with `error` set ("line 12: unknown track 'bas'") on a bad file.
+inline bool loadScore(const std::string& path, Score& score,
+                      std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    score = Score();
+    std::string line;
+    for (int lineNo = 1; std::getline(file, line); lineNo++) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream in(line);
+        std::string first;
+        if (!(in >> first)) continue;
+
+        auto fail = [&](const std::string& what) {
+            error = "line " + std::to_string(lineNo) + ": " + what;
+            return false;
+        };
+
+        if (first == "track") {
+            ScoreTrack t{ "", nullptr, 1.0f };
+            std::string instrument;
+            if (!(in >> t.name >> instrument)) return fail("track <name> <instrument> [gain]");
+            in >> t.gain;
+            t.info = findInstrument(instrument.c_str());
+            if (!t.info) return fail("unknown instrument '" + instrument + "'");
+            score.tracks.push_back(t);
+            continue;
+        }
+        if (first == "length" || first == "tail") {
+            double v;
+            if (!(in >> v) || v < 0.0) return fail(first + " <seconds>");
+            (first == "length" ? score.length : score.tail) = v;
+            continue;
+        }
+
+        double time;
+        std::string trackName, what;
+        try {
+            time = std::stod(first);
+        } catch (...) {
+            return fail("unknown statement '" + first + "'");
+        }
+        if (time < 0.0 || !(in >> trackName >> what))
+            return fail("<time> <track> <note> <velocity> [length]");
+
+        int track = -1;
+        for (size_t i = 0; i < score.tracks.size(); i++)
+            if (score.tracks[i].name == trackName) track = int(i);
+        if (track < 0) return fail("unknown track '" + trackName + "'");
+
+        int64_t frame = secondsToFrames(time);
+        if (what == "cc") {
+            int cc;
+            float value;
+            if (!(in >> cc >> value)) return fail("<time> <track> cc <number> <value>");
+            score.events.push_back({ frame, track, cc, 0, value });
+        } else {
+            int note = atoi(what.c_str());
+            float velocity;
+            double length;
+            if (!(in >> velocity)) return fail("<time> <track> <note> <velocity> [length]");
+            score.events.push_back({ frame, track, -1, note, velocity });
+            if (in >> length)
+                score.events.push_back(
+                    { frame + secondsToFrames(length), track, -1, note, 0.0f });
+        }
+    }
+
+    finishScore(score);
+    return true;
+}
+
+// Plays the score `loops` times back to back, one `length` apart.
+inline void loopScore(Score& score, int loops) {
+    int64_t period = score.frames - secondsToFrames(score.tail);
+    std::vector<ScoreEvent> once = score.events;
+    for (int l = 1; l < loops; l++)
+        for (ScoreEvent e : once) {
+            e.frame += l * period;
+            score.events.push_back(e);
+        }
+    finishScore(score);
+}
+
+// =====================
+// RENDER
+// =====================
+// Each track gets its own instrument instance and buffer; the mix adds
+// the buffers in track order. Events are sample-accurate: a MAX_BLOCK
+// block is split where one falls, on a grid fixed by absolute time.
+//
+// In parallel, every track's timeline is cut into `segmentFrames` pieces
+// and each (track, piece) is a job for the pool. A job starts a fresh
+// instrument at its piece (controllers before it replayed), renders to
+// the end of the piece, then carries on until the instrument is idle()
+// at a block boundary (giving up a further piece on), and notes where it
+// was idle along the way. Stitching then follows the serial timeline:
+// from a point p where the serial render is known to be idle (0 first),
+// any job that covers p, was idle at p and ended idle continues it
+// exactly, up to its end. Where none does, a fresh job is rendered on
+// the spot from p until the track rests, however long that is. So the
+// result is bit-identical to the serial render for any thread count and
+// piece length; how well it scales depends on how often tracks rest.
+struct RenderStats {
+    int jobs = 0;
+    int handoffs = 0;       // pieces joined at an idle point
+    int fallbacks = 0;      // pieces rendered again while stitching
+    int64_t rendered = 0;   // frames rendered, overlap included
+};
+
+struct TrackPiece {
+    int64_t start = 0;
+    int64_t stopAfter = 0;            // stop at the first idle point >= this
+    int64_t giveUpAt = INT64_MAX;     // ... or here, not idle
+    int64_t end = 0;
+    bool endsIdle = false;
+    std::vector<float> out;           // [start, end)
+    std::vector<uint8_t> idleAt;      // per block boundary from start
+};
+
+inline void renderPiece(const Score& score, int track, TrackPiece& piece) {
+    std::unique_ptr<Instrument> inst = score.tracks[track].info->create();
+    inst->prepare(SAMPLE_RATE, MAX_BLOCK);
+
+    auto apply = [&](const ScoreEvent& e) {
+        if (e.cc >= 0) inst->control(e.cc, e.value);
+        else if (e.value > 0.0f) inst->noteOn(e.note, e.value);
+        else inst->noteOff(e.note);
+    };
+
+    // controllers set before the piece; notes there are someone else's
+    size_t next = 0;
+    for (; next < score.events.size()
+           && score.events[next].frame < piece.start; next++)
+        if (score.events[next].track == track && score.events[next].cc >= 0)
+            apply(score.events[next]);
+
+    int64_t pos = piece.start;
+    while (pos < score.frames) {
+        bool idle = inst->idle();
+        piece.idleAt.push_back(idle);
+        if (idle && pos >= piece.stopAfter) {
+            piece.endsIdle = true;
+            break;
+        }
+        if (pos >= piece.giveUpAt) break;
+
+        int64_t blockEnd = std::min(pos + MAX_BLOCK, score.frames);
+        piece.out.resize(size_t(blockEnd - piece.start), 0.0f);
+        NoAllocScope noAlloc;
+        while (pos < blockEnd) {
+            for (; next < score.events.size()
+                   && score.events[next].frame <= pos; next++)
+                if (score.events[next].track == track)
+                    apply(score.events[next]);
+
+            int64_t to = blockEnd;
+            if (next < score.events.size())
+                to = std::min(to, std::max(pos + 1, score.events[next].frame));
+            inst->renderBlock(piece.out.data() + (pos - piece.start),
+                              int(to - pos));
+            pos = to;
+        }
+    }
+    piece.end = pos;
+}
+
+// Renders the score into `mix` on up to `threads` threads.
+inline RenderStats renderScore(const Score& score, int threads,
+                               int64_t segmentFrames, std::vector<float>& mix) {
+    RenderStats stats;
+    int numTracks = int(score.tracks.size());
+    threads = std::max(1, threads);
+
+    // serial: one piece per track, in one go
+    segmentFrames = threads == 1 ? score.frames
+                                 : std::max<int64_t>(MAX_BLOCK, segmentFrames);
+    segmentFrames = (segmentFrames + MAX_BLOCK - 1) / MAX_BLOCK * MAX_BLOCK;
+    int perTrack = int(std::max<int64_t>(
+        1, (score.frames + segmentFrames - 1) / segmentFrames));
+
+    std::vector<std::vector<TrackPiece>> pieces(numTracks,
+                                                std::vector<TrackPiece>(perTrack));
+    for (auto& track : pieces)
+        for (int k = 0; k < perTrack; k++) {
+            track[k].start = k * segmentFrames;
+            track[k].stopAfter = std::min(score.frames, (k + 1) * segmentFrames);
+            track[k].giveUpAt = (k + 2) * segmentFrames;
+        }
+
+    // earlier pieces first, all tracks side by side
+    int jobs = numTracks * perTrack;
+    std::atomic<int> nextJob(0);
+    auto worker = [&]() {
+        for (int j = nextJob++; j < jobs; j = nextJob++)
+            renderPiece(score, j % numTracks, pieces[j % numTracks][j / numTracks]);
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < std::min(threads, jobs); t++)
+        pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool)
+        t.join();
+    stats.jobs = jobs;
+
+    mix.assign(size_t(score.frames), 0.0f);
+    std::vector<float> trackOut(size_t(score.frames));
+    for (int t = 0; t < numTracks; t++) {
+        for (const TrackPiece& piece : pieces[t])
+            stats.rendered += piece.end - piece.start;
+
+        int64_t p = 0;
+        while (p < score.frames) {
+            const TrackPiece* owner = nullptr;
+            for (const TrackPiece& piece : pieces[t]) {
+                if (piece.start > p || piece.end <= p) continue;
+                if (!piece.endsIdle && piece.end < score.frames) continue;
+                if (piece.start < p
+                    && !piece.idleAt[size_t((p - piece.start) / MAX_BLOCK)])
+                    continue;
+                if (!owner || piece.start > owner->start) owner = &piece;
+            }
+
+            TrackPiece again;
+            if (!owner) {
+                again.start = p;
+                again.stopAfter = std::min(score.frames, p + segmentFrames);
+                renderPiece(score, t, again);
+                stats.rendered += again.end - again.start;
+                stats.fallbacks++;
+                owner = &again;
+            } else if (p > 0) {
+                stats.handoffs++;
+            }
+
+            std::copy(owner->out.begin() + (p - owner->start), owner->out.end(),
+                      trackOut.begin() + p);
+            p = owner->end;
+        }
+
+        float gain = score.tracks[t].gain;
+        for (size_t i = 0; i < mix.size(); i++)
+            mix[i] += gain * trackOut[i];
+    }
+    return stats;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+
+// =====================
+// SPSC QUEUE
+// =====================
+// Fixed-capacity ring for handing small structs from one thread to
+// another (typically input -> audio). push() fails when full rather
+// than blocking; neither side allocates or locks.
+template <typename T, int CAPACITY = 256>
+class SpscQueue {
+public:
+    bool push(const T& item) {
+        int head = head_.load(std::memory_order_relaxed);
+        int next = (head + 1) % CAPACITY;
+        if (next == tail_.load(std::memory_order_acquire))
+            return false;
+        items_[head] = item;
+        head_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) {
+        int tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire))
+            return false;
+        item = items_[tail];
+        tail_.store((tail + 1) % CAPACITY, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T items_[CAPACITY];
+    alignas(64) std::atomic<int> head_{0};
+    alignas(64) std::atomic<int> tail_{0};
+};
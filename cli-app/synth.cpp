@@ -1,514 +1,954 @@
 #include <iostream>
+#include <iomanip>
 #include <cmath>
 #include <random>
 #include <atomic>
-#include <termios.h>
+#include <cstring>
+#include <chrono>
+#include <thread>
 #include <unistd.h>
 
-#include <portaudio.h>
-
-constexpr int SAMPLE_RATE = 44100;
-
-// =====================
-// LENGTHS
-// =====================
-constexpr double SNARE_DUR = 0.15;
-constexpr double KICK_DUR  = 0.5;
-constexpr double HAT_DUR   = 0.08;
-
-constexpr double PIANO_DUR = 2.5;
-constexpr int PIANO_N = int(PIANO_DUR * SAMPLE_RATE);
-constexpr int MAX_PIANO_NOTES = 20;
-
-constexpr int SNARE_N = int(SNARE_DUR * SAMPLE_RATE);
-constexpr int KICK_N  = int(KICK_DUR  * SAMPLE_RATE);
-constexpr int HAT_N   = int(HAT_DUR   * SAMPLE_RATE);
-
-
+#include "arena.h"
+#include "dsp.h"
+#include "voices.h"
+#include "piano_bank.h"
+#include "instrument.h"
+#include "rt.h"
+#include "input.h"
+#include "analysis.h"
+#include "osc.h"
+#include "resampler.h"
+#include "scheduler.h"
+#include "wav.h"
+#include "backends/registry.h"
+#include "instruments/kick.h"
+#include "instruments/registry.h"
+
+// What the keyboard plays; every channel sounds whatever the mode (see
+// CHANNELS).
 enum class Mode {
     Drum,
-    Piano
+    Piano,
+    Instrument,  // hosted with --instrument
+    Session      // all of them at once
 };
 
 std::atomic<Mode> currentMode(Mode::Drum);
 
 int octave = 0;  // 0 = C4, +1 = C5, -1 = C3
-// octave = std::max(-2, std::min(2, octave));
 
 // =====================
 // BUFFERS
 // =====================
-float snare[SNARE_N];
-float kick[KICK_N];
-float hihat[HAT_N];
+SampleBuffer snare;
+SampleBuffer hihat;
+SampleBuffer openHat;
+
+// background work: render-ahead and warming for the piano banks, and
+// --render-octaves' re-renders (so it outlives them). Started in main
+// only if one of those needs it, with a few workers that leave a core
+// to the audio thread.
+constexpr int MAX_JOB_THREADS = 2;
+std::unique_ptr<Scheduler> jobs;
+
+// The octave keys pitch the one bank's voices up or down (see
+// VoiceBank). With --render-octaves they re-render it at the octave
+// instead, and there are two banks so that never rewrites samples the
+// audio thread is reading: the new octave renders into the spare, as a
+// background job while the old one keeps playing, then becomes `piano`.
+// Only the input thread touches these pointers.
+bool renderOctaves = false;
+PianoBank pianoBanks[2];
+PianoBank* piano = &pianoBanks[0];
+// the spare is being rendered; then it is handed back at `spareOctave`
+std::atomic<bool> spareRendering(false);
+std::atomic<PianoBank*> spareRendered(nullptr);
+int spareOctave = 0;
+// `piano` and its pitch step as the audio thread sees them, for OSC
+// piano notes
+std::atomic<PianoBank*> livePiano(&pianoBanks[0]);
+std::atomic<float> livePianoStep(1.0f);
+double velocity = 1.0;  // set with 1..9
+
+// The pedal and note-off are applied by the mixer (see VoiceBank), so
+// neither touches the banks.
+bool sustainPedal = false;
 
 // =====================
+// CHANNELS
+// =====================
+// The session: parts that play at the same time, each on a voice pool
+// of its own, mixed by the callback in one pass.
+//
+//   drums    snare and hi-hats on a VoiceBank, the kick live
+//   piano    the piano bank on a second VoiceBank
+//   hosted   --instrument, with its PolyInstrument's pool
+//
+// Each has its own keymap (see KEYMAPS) and its own share of every
+// callback, timed, so Tab can say how many such parts a period holds.
+enum Channel { CH_DRUMS, CH_PIANO, CH_HOSTED, CHANNELS };
 
+const char* const CHANNEL_NAMES[CHANNELS] = { "drums", "piano", "hosted" };
 
+TimingHistogram channelTimes[CHANNELS];  // per callback
 
+// =====================
+// SOURCES
+// =====================
+// per channel: the drums' voices
+enum DrumSource {
+    SRC_SNARE,
+    SRC_HAT,
+    SRC_OPEN_HAT
+};
 
+// and their choke groups (see VoiceBank): either hi-hat cuts the other,
+// and a snare cuts its own last hit rather than restarting it
+enum ChokeGroup : uint8_t {
+    CHOKE_HATS = 1,
+    CHOKE_SNARE
+};
 
+// the piano's: 2 * note index (two velocity layers per key),
+// + 2 * MAX_PIANO_NOTES for the second bank
+int pianoSources(const PianoBank* bank) {
+    return int(bank - pianoBanks) * 2 * MAX_PIANO_NOTES;
+}
 
-
-
-
-
-
-// PLAYHEADS
 // =====================
-std::atomic<int> snarePH(-1);
-std::atomic<int> kickPH(-1);
-std::atomic<int> hatPH(-1);
+// ENGINE STATE
+// =====================
+VoiceBank drumVoices;         // audio thread only
+VoiceBank pianoVoices;        // likewise
+TriggerQueue drumTriggers;    // input thread -> audio thread
+TriggerQueue pianoTriggers;   // likewise
 
+Kick kick;                           // synthesized live, not pre-rendered
+NoteQueue kickHits;                  // input thread -> audio thread
 
-float piano[MAX_PIANO_NOTES][PIANO_N];
-std::atomic<int> pianoPH[MAX_PIANO_NOTES];
+// The audio callback's scratch: allocated and touched before it runs,
+// rewound at the top of every callback.
+constexpr size_t BLOCK_SCRATCH_BYTES = 4 * MAX_BLOCK * sizeof(float);
+Arena blockScratch;
 
+std::atomic<uint64_t> callbacksDone(0);
+bool streaming = false;              // set once the backend runs
 
-bool sustainPedal = false;
+std::unique_ptr<Instrument> hosted;  // optional, from --instrument
+NoteQueue hostedNotes;               // input thread -> audio thread
+ControlQueue hostedControls;         // likewise
+int hostedOctave = 0;
+float hostedBrightness = 0.5f;       // cc 74, '-' / '='
+float hostedModWheel = 0.1f;         // cc 1, ',' / '.'
 
 
 // =====================
-// LOWPASS
+// RT STATE
 // =====================
-double lowpass(double input, double& state, double cutoffHz) {
-    double RC = 1.0 / (2.0 * M_PI * cutoffHz);
-    double dt = 1.0 / SAMPLE_RATE;
-    double alpha = dt / (RC + dt);
-    state += alpha * (input - state);
-    return state;
+constexpr int RT_PRIORITY = 70;
+
+bool rtHardening = true;  // --no-rt turns it off for comparison
+RtReport rt;
+TimingHistogram callbackTimes;
+
+// kernel (evdev) or read (stdin) time of each sounding key, so the
+// callback that starts it can tell how long it took to get there
+SpscQueue<int64_t> keyStamps;
+TimingHistogram inputLatency;
+
+// --osc: events from other processes, straight to the audio thread and
+// stamped on arrival
+OscListener osc;
+OscQueue oscEvents;
+TimingHistogram oscLatency;
+
+// master-bus tap (--analyze)
+Analyzer analyzer;
+
+// what has been written of `s`; the rest is faulted in by its writer
+size_t prefaultSamples(const SampleBuffer& s) {
+    size_t n = s.ready ? size_t(s.ready->load()) : size_t(s.length);
+    switch (s.format) {
+    case SampleFormat::Float32:
+        return prefault(s.f32.data(), n * sizeof(float));
+    case SampleFormat::Int16:
+        return prefault(s.i16.data(), n * sizeof(int16_t));
+    case SampleFormat::BlockFloat8:
+        return prefault(s.m8.data(), n)
+             + prefault(s.blockScale.data(),
+                        (n + BFP_BLOCK - 1) / BFP_BLOCK * sizeof(float));
+    }
+    return 0;
 }
 
-// =====================
-// SNARE
-// =====================
-void generateSnare() {
-    std::mt19937 rng(1234);
-    std::uniform_real_distribution<double> noise(-1.0, 1.0);
+void trigger(const SampleBuffer& sample, int source, uint8_t choke) {
+    drumTriggers.push({ &sample, 1.0f, source, nullptr, Trigger::Start, 1.0f,
+                        choke });
+}
 
-    double noiseLP = 0.0;
-    double outLP = 0.0;
+// A drum from a WAV file (its first channel), converted to SAMPLE_RATE
+// if it was recorded at another rate.
+bool loadDrum(const std::string& path, SampleBuffer& s) {
+    std::vector<float> in;
+    int rate = SAMPLE_RATE;
+    if (!readWav(path.c_str(), in, &rate) || in.empty() || rate <= 0)
+        return false;
+    std::vector<float> out = resample(in, rate, SAMPLE_RATE);
+    s.allocate(SampleFormat::Float32, int(out.size()));
+    s.encode(out.data());
+    std::cout << path << ": " << in.size() << " frames at " << rate
+              << " Hz -> " << out.size() << " at " << SAMPLE_RATE << "\n";
+    return true;
+}
 
-    for (int i = 0; i < SNARE_N; i++) {
-        double t = double(i) / SAMPLE_RATE;
+// the synthesized drums, or the WAVs given for them
+bool renderDrums(const std::string& snareWav, const std::string& hatWav) {
+    if (snareWav.empty()) {
+        snare.allocate(SampleFormat::Float32, SNARE_N);
+        generateSnare(snare.f32.data());
+    } else if (!loadDrum(snareWav, snare)) {
+        std::cerr << snareWav << ": not a WAV file this reads\n";
+        return false;
+    }
+    if (hatWav.empty()) {
+        hihat.allocate(SampleFormat::Float32, HAT_N);
+        generateHiHat(hihat.f32.data());
+    } else if (!loadDrum(hatWav, hihat)) {
+        std::cerr << hatWav << ": not a WAV file this reads\n";
+        return false;
+    }
+    openHat.allocate(SampleFormat::Float32, OPEN_HAT_N);
+    generateOpenHiHat(openHat.f32.data());
 
-        double noiseEnv = exp(-t * 14.0) * (1.0 - exp(-t * 180.0));
-        double toneEnv  = exp(-t * 22.0);
+    kick.prepare(SAMPLE_RATE, MAX_BLOCK);
+    return true;
+}
 
-        double n = noise(rng) * noiseEnv;
-        n = lowpass(n, noiseLP, 5500.0);
+// Returns once the audio thread has drained everything queued before
+// the call: a callback that started after it has completed.
+void waitForAudioThread() {
+    if (!streaming) return;
+    uint64_t seen = callbacksDone.load();
+    while (callbacksDone.load() < seen + 2)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
 
-        double tone = sin(2.0 * M_PI * 150.0 * t);
-        tone = tanh(tone * 2.0) * toneEnv;
+Job renderSpare(PianoBank* spare, int toOctave) {
+    auto t0 = std::chrono::steady_clock::now();
+    spare->render(pow(2.0, toOctave));
+    std::cout << "Octave: " << toOctave << " (rendered in "
+              << std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - t0).count()
+              << " ms)\n";
+    spareOctave = toOctave;
+    spareRendered.store(spare, std::memory_order_release);
+    spareRendering.store(false, std::memory_order_release);
+    co_return;
+}
 
-        double s = 0.9 * n + 0.25 * tone;
-        s = lowpass(s, outLP, 6000.0);
-        s = tanh(s * 1.4);
+// Starts rendering the spare bank at `octave`, unless it is busy; the
+// input thread adopts it when done (see adoptPiano).
+void regeneratePiano() {
+    if (spareRendering.load(std::memory_order_acquire)
+        || spareRendered.load(std::memory_order_acquire))
+        return;
+    PianoBank* spare = piano == &pianoBanks[0] ? &pianoBanks[1]
+                                               : &pianoBanks[0];
+
+    // notes from the previous octave may still ring out of the spare;
+    // stop them and make sure the mixer has let go before rewriting it.
+    // Its render-ahead is ended here too: those jobs need the workers
+    // the render is about to hold.
+    int src = pianoSources(spare);
+    for (int s = 0; s < 2 * MAX_PIANO_NOTES; s++)
+        pianoTriggers.push({ nullptr, 0.0f, src + s });
+    waitForAudioThread();
+    spare->stopAhead();
+
+    spareRendering.store(true, std::memory_order_release);
+    jobs->spawn(renderSpare(spare, octave), Priority::Background);
+}
 
-        snare[i] = (float)s;
-    }
+// On the input thread: a finished spare becomes `piano`, and if the
+// octave moved on while it rendered, the other bank starts over.
+void adoptPiano() {
+    PianoBank* bank = spareRendered.load(std::memory_order_acquire);
+    if (!bank) return;
+    piano = bank;
+    livePiano.store(bank, std::memory_order_release);
+    spareRendered.store(nullptr, std::memory_order_release);
+    if (spareOctave != octave)
+        regeneratePiano();
+}
+
+// the voices' pitch step for the octave; 1 when the bank is rendered at it
+float pianoStep() {
+    return renderOctaves ? 1.0f : float(pow(2.0, octave));
 }
 
 // =====================
-// KICK
+// OSC
 // =====================
-void generateKick() {
-    double phase = 0.0;
-
-    for (int i = 0; i < KICK_N; i++) {
-        double t = double(i) / SAMPLE_RATE;
-
-        double ampEnv = exp(-t * 8.0);
-        double freq = 40.0 + (80.0 - 40.0) * exp(-t * 20.0);
-
-        phase += 2.0 * M_PI * freq / SAMPLE_RATE;
+// Applies an OscEvent on the audio thread. Its voices start here rather
+// than through the channels' queues, whose producer is the input thread.
+struct StartNow {
+    VoiceBank& voices;
+
+    bool push(const Trigger& t) {
+        startVoice(voices, t);
+        return true;
+    }
+};
 
-        double s = sin(phase) * ampEnv;
-        kick[i] = (float)tanh(s * 1.2);
+int oscVariant[MAX_PIANO_NOTES] = {};    // round robin, audio thread
+int oscPianoBase[MAX_PIANO_NOTES] = {};  // sources each key last played on
+
+void playOsc(const OscEvent& e) {
+    StartNow drums{ drumVoices };
+    StartNow now{ pianoVoices };
+    switch (e.kind) {
+    case OscEvent::Drum:
+        if (e.index == OscEvent::Kick)
+            kick.noteOn(36, e.value);
+        else if (e.index == OscEvent::Snare)
+            drums.push({ &snare, e.value, SRC_SNARE, nullptr, Trigger::Start,
+                         1.0f, CHOKE_SNARE });
+        else
+            drums.push({ e.index == OscEvent::Hat ? &hihat : &openHat,
+                         e.value,
+                         e.index == OscEvent::Hat ? SRC_HAT : SRC_OPEN_HAT,
+                         nullptr, Trigger::Start, 1.0f, CHOKE_HATS });
+        break;
+    case OscEvent::Piano:
+        if (e.value > 0.0f) {
+            PianoBank* bank = livePiano.load(std::memory_order_acquire);
+            int variant = oscVariant[e.index];
+            oscVariant[e.index] = (variant + 1) % bank->variants;
+            oscPianoBase[e.index] = pianoSources(bank);
+            bank->playVariant(now, oscPianoBase[e.index], e.index,
+                              std::min(1.0f, e.value), variant,
+                              livePianoStep.load(std::memory_order_relaxed));
+        } else {
+            PianoBank::release(now, oscPianoBase[e.index], e.index);
+        }
+        break;
+    case OscEvent::Note:
+        if (!hosted) break;
+        if (e.value > 0.0f) hosted->noteOn(e.index, e.value);
+        else hosted->noteOff(e.index);
+        break;
+    case OscEvent::Control:
+        if (hosted) hosted->control(e.index, e.value);
+        break;
+    case OscEvent::Pedal:
+        now.push({ nullptr, e.value > 0.0f ? 1.0f : 0.0f, 0, nullptr,
+                   Trigger::Pedal });
+        break;
     }
 }
 
 // =====================
-// HI-HAT (closed, Linn-ish)
+// AUDIO CALLBACK
 // =====================
-void generateHiHat() {
-    std::mt19937 rng(5678);
-    std::uniform_real_distribution<double> noise(-1.0, 1.0);
-
-    double hp = 0.0;
-    double lp = 0.0;
-
-    for (int i = 0; i < HAT_N; i++) {
-        double t = double(i) / SAMPLE_RATE;
-
-        // very fast decay
-        double env = exp(-t * 60.0);
-
-        double n = noise(rng);
-
-        // crude band-pass: HP then LP
-        double high = n - lowpass(n, hp, 6000.0);
-        double band = lowpass(high, lp, 10000.0);
-
-        double s = band * env * 0.7;
-        hihat[i] = (float)tanh(s);
+// Called by the backend's audio thread; fills `frameCount` samples.
+void renderAudio(float* out, int frameCount) {
+    auto start = std::chrono::steady_clock::now();
+
+    // first callback: the thread is the audio thread from here on
+    static bool firstCall = true;
+    if (firstCall) {
+        firstCall = false;
+        if (rtHardening) {
+            prefaultStack();
+            if (setRealtime(RT_PRIORITY)) {
+                rt.priority = RT_PRIORITY;
+                rt.realtime = true;
+            }
+        }
     }
-}
-
-
-
-
-
-
-// void generatePianoNote(float* buffer, double freq) {
-//     for (int i = 0; i < PIANO_N; i++) {
-//         double t = double(i) / SAMPLE_RATE;
-
-//         // soft attack + long decay
-//         double env =
-//             (1.0 - exp(-t * 6.0)) *   // attack
-//             exp(-t * 1.6);            // decay
-
-//         double s = 0.0;
-
-//         for (int k = 1; k <= 8; k++) {
-//             double harmAmp = (1.0 / k) * exp(-t * k * 2.5);
-//             s += harmAmp * sin(2.0 * M_PI * k * freq * t);
-//         }
-
-//         buffer[i] = (float)(s * env * 0.25);
-//     }
-// }
-
 
+    int64_t stamp;
+    int64_t nowNs = monotonicNs();
+    while (keyStamps.pop(stamp))
+        inputLatency.record(uint64_t(std::max<int64_t>(0, nowNs - stamp)),
+                            uint64_t(1e9 * frameCount / SAMPLE_RATE));
+
+    NoDenormals noDenormals(rtHardening);
+    if (rtHardening)
+        rt.denormalsOff = NoDenormals::supported();
+    NoAllocScope noAlloc;
+    ArenaScope scratch(blockScratch);
+
+    Trigger t;
+    while (drumTriggers.pop(t))
+        startVoice(drumVoices, t);
+    while (pianoTriggers.pop(t))
+        startVoice(pianoVoices, t);
+
+    NoteEvent e;
+    while (kickHits.pop(e))
+        kick.noteOn(e.note, e.velocity);
+
+    while (hostedNotes.pop(e)) {
+        if (e.velocity > 0.0f) hosted->noteOn(e.note, e.velocity);
+        else hosted->noteOff(e.note);
+    }
 
-struct Resonator {
-    double y1 = 0.0, y2 = 0.0;
-    double a1, a2, b0;
+    ControlEvent cc;
+    while (hostedControls.pop(cc))
+        hosted->control(cc.cc, cc.value);
 
-    void setup(double freq, double decay) {
-        double r = exp(-decay);
-        double w = 2.0 * M_PI * freq / SAMPLE_RATE;
-        a1 = -2.0 * r * cos(w);
-        a2 = r * r;
-        b0 = 1.0 - r;
+    OscEvent oe;
+    while (oscEvents.pop(oe)) {
+        oscLatency.record(uint64_t(std::max<int64_t>(0, nowNs - oe.timeNs)),
+                          uint64_t(1e9 * frameCount / SAMPLE_RATE));
+        playOsc(oe);
     }
 
-    inline double process(double x) {
-        double y = b0 * x - a1 * y1 - a2 * y2;
-        y2 = y1;
-        y1 = y;
-        return y;
+    float* mix = blockScratch.alloc<float>(MAX_BLOCK);
+    if (!mix) {  // sized for it; never
+        std::fill(out, out + frameCount, 0.0f);
+        callbacksDone.fetch_add(1, std::memory_order_release);
+        return;
+    }
+    int64_t spent[CHANNELS] = {};
+
+    for (int done = 0; done < frameCount; ) {
+        int n = std::min(frameCount - done, MAX_BLOCK);
+
+        std::fill(mix, mix + n, 0.0f);
+        int64_t t0 = monotonicNs();
+        mixVoices(drumVoices, mix, n);
+        kick.renderBlock(mix, n);
+        int64_t t1 = monotonicNs();
+        mixVoices(pianoVoices, mix, n);
+        int64_t t2 = monotonicNs();
+        if (hosted)
+            hosted->renderBlock(mix, n);
+        int64_t t3 = monotonicNs();
+        spent[CH_DRUMS] += t1 - t0;
+        spent[CH_PIANO] += t2 - t1;
+        spent[CH_HOSTED] += t3 - t2;
+
+        for (int i = 0; i < n; i++)
+            out[done + i] = tanh(mix[i] * 0.8f);
+
+        done += n;
     }
-};
-
-
-void generatePianoNote(float* buffer, double freq, bool sustain) {
-    double pitch = std::clamp(
-        (log2(freq / 55.0)) / 5.0,
-        0.0, 1.0
-    );
-
-    bool bass = freq < 110.0;
-
-    int maxHarmonics = bass ? 3 : int(6 + pitch * 10);
-    double inharmAmount = bass ? 0.00005 : (0.0002 + pitch * 0.001);
-    double attackRate = bass ? 8.0 : (15.0 + pitch * 40.0);
-
-    double boardMix = bass ? 0.85 : (0.8 - pitch * 0.35);
-    double noiseLevel = bass ? 0.45 : (1.0 - pitch) * 0.2;
-
-    double detune[3] = {
-        -0.0008 * pitch,
-         0.0,
-        +0.0012 * pitch
-    };
 
-    Resonator board[4];
-    board[0].setup(90.0,  0.0015);
-    board[1].setup(180.0, 0.0025);
-    board[2].setup(420.0, 0.0035);
-    board[3].setup(900.0, 0.005);
+    uint64_t periodNs = uint64_t(1e9 * frameCount / SAMPLE_RATE);
+    for (int ch = 0; ch < CHANNELS; ch++)
+        if (ch != CH_HOSTED || hosted)
+            channelTimes[ch].record(uint64_t(spent[ch]), periodNs);
 
-    Resonator air;
-    air.setup(2500.0, 0.015);  // short “air splash”
+    analyzer.push(out, frameCount);
 
-    for (int i = 0; i < PIANO_N; i++) {
-        double t = double(i) / SAMPLE_RATE;
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    callbackTimes.record(uint64_t(ns),
+                         uint64_t(1e9 * frameCount / SAMPLE_RATE));
+    callbacksDone.fetch_add(1, std::memory_order_release);
+}
 
-        double env =
-            (1.0 - exp(-t * attackRate)) *
-            exp(-t * (sustain ? 0.35 : (bass ? 0.9 : 1.4)));
+// =====================
+// KEYMAPS
+// =====================
+// The keys that play a channel, in order: key i plays the i-th drum
+// (kick, snare, hi-hat, open hi-hat) or the note i semitones up. Drum,
+// Piano and Instrument mode reach one channel each; Session mode
+// reaches them all at once, with the drums moved to the bottom row so
+// the home row is free, and the piano and a hosted instrument layered
+// on it.
+struct Keymap {
+    const char* keys;
+
+    int at(char c) const {
+        const char* k = strchr(keys, c);
+        return (c && k) ? int(k - keys) : -1;
+    }
+};
 
-        double s = 0.0;
+enum Drum { DRUM_KICK, DRUM_SNARE, DRUM_HAT, DRUM_OPEN_HAT };
+
+const Keymap DRUM_KEYS         = { " jfd" };
+const Keymap SESSION_DRUM_KEYS = { "zxcv" };
+const Keymap PIANO_KEYS        = { "awsedftgyhujkolp;']\\" };  // from C
+
+// `channel`'s keymap in `mode`, or null if the mode does not play it
+const Keymap* keymap(Channel channel, Mode mode) {
+    bool session = mode == Mode::Session;
+    switch (channel) {
+    case CH_DRUMS:
+        return session ? &SESSION_DRUM_KEYS
+             : mode == Mode::Drum ? &DRUM_KEYS : nullptr;
+    case CH_PIANO:
+        return session || mode == Mode::Piano ? &PIANO_KEYS : nullptr;
+    case CH_HOSTED:
+        return hosted && (session || mode == Mode::Instrument)
+             ? &PIANO_KEYS : nullptr;
+    default:
+        return nullptr;
+    }
+}
 
-        // --- STRINGS (de-idealized) ---
-        for (int st = 0; st < 3; st++) {
-            double f = freq * (1.0 + detune[st]);
+// Each channel's cost per callback, and how many parts like it one
+// callback period would hold on average and at its worst.
+void printChannels(std::ostream& os, double periodUs) {
+    os << "channels (share of each " << periodUs << " us callback):\n";
+    for (int ch = 0; ch < CHANNELS; ch++) {
+        const TimingHistogram& h = channelTimes[ch];
+        if (h.total == 0) continue;
+        double meanUs = h.meanUs();
+        double maxUs = h.maxNs / 1000.0;
+        os << "  " << std::left << std::setw(8) << CHANNEL_NAMES[ch]
+           << std::right << "mean " << std::setw(7) << meanUs << " us ("
+           << 100.0 * meanUs / periodUs << "%), max " << std::setw(7)
+           << maxUs << " us; fits " << int(periodUs / std::max(meanUs, 0.1))
+           << " such parts (" << int(periodUs / std::max(maxUs, 0.1))
+           << " at its worst)\n";
+    }
+    os << "  scratch: peak " << blockScratch.peak() << " of "
+       << blockScratch.capacity() << " bytes, " << blockScratch.failures()
+       << " allocation(s) did not fit\n";
+}
 
-            for (int k = 1; k <= maxHarmonics; k++) {
-                double inharm = 1.0 + inharmAmount * k * k;
-                double hf = f * k * inharm;
+// =====================
+// KEYS
+// =====================
+// What a key does in the current mode. Only evdev reports key-up; it
+// ends the note the key started, even if the mode or octave changed
+// while it was held, and space in piano mode is then a held pedal
+// rather than a toggle.
+int heldNote[256] = {};       // hosted note + 1 per key, 0 = none
+int heldPianoKey[256] = {};   // piano key + 1 per key, 0 = none
+int heldPianoBase[256] = {};  // ... and the sources it was played on
+
+void setSustainPedal(bool down) {
+    sustainPedal = down;
+    pianoTriggers.push({ nullptr, down ? 1.0f : 0.0f, 0, nullptr, Trigger::Pedal });
+    std::cout << "Pedal: " << (down ? "down" : "up") << "\n";
+}
 
-                double amp =
-                    (1.0 / k) *
-                    exp(-t * k * (bass ? 4.5 : 2.5));
+void printMode() {
+    switch (currentMode.load()) {
+    case Mode::Drum:
+        std::cout << "\n[ DRUM MODE ]\n";
+        break;
+    case Mode::Piano:
+        std::cout << "\n[ PIANO MODE ]  space = sustain pedal\n";
+        break;
+    case Mode::Instrument:
+        std::cout << "\n[ INSTRUMENT MODE ]  - = brightness, , . "
+                     "mod wheel\n";
+        break;
+    case Mode::Session:
+        std::cout << "\n[ SESSION ]  z x c v = kick snare hi-hat open, home row = "
+                  << (hosted ? "piano + instrument" : "piano")
+                  << ", space = sustain pedal\n";
+        break;
+    }
+}
 
-                // slight phase chaos in bass
-                double phaseJitter = bass ? sin(t * 1200.0) * 0.002 : 0.0;
+void handleKey(const KeyEvent& e, const AudioBackend& backend,
+               const AudioConfig& audio) {
+    unsigned char c = (unsigned char)e.key;
 
-                s += amp * sin(2.0 * M_PI * hf * t + phaseJitter);
-            }
+    if (!e.down) {
+        if (heldNote[c]) {
+            hostedNotes.push({ heldNote[c] - 1, 0.0f });
+            heldNote[c] = 0;
         }
+        if (heldPianoKey[c]) {
+            PianoBank::release(pianoTriggers, heldPianoBase[c],
+                               heldPianoKey[c] - 1);
+            heldPianoKey[c] = 0;
+        }
+        if (c == ' ' && sustainPedal)
+            setSustainPedal(false);
+        return;
+    }
 
-        // --- HAMMER SCRAPE (THIS IS THE KEY) ---
-        double hammerNoise =
-            ((rand() / (double)RAND_MAX) * 2.0 - 1.0) *
-            exp(-t * (bass ? 120.0 : 220.0));
-
-        double hammer = hammerNoise * noiseLevel;
-
-        // metallic scrape burst
-        hammer +=
-            exp(-t * 90.0) *
-            sin(2.0 * M_PI * (bass ? 1800.0 : 3200.0) * t) *
-            (bass ? 0.25 : 0.08);
-
-        // --- SOUNDBOARD ---
-        double boardOut = 0.0;
-        for (int r = 0; r < 4; r++)
-            boardOut += board[r].process(s + hammer);
-
-        // --- AIR BLOOM ---
-        double airOut = air.process(s + hammer);
-
-        double sample =
-            (s * (1.0 - boardMix) +
-             boardOut * boardMix +
-             airOut * 0.15 +
-             hammer * 0.3) * env;
+    bool sounded = false;
+
+    if (c == '\n') {
+        if (currentMode == Mode::Drum)
+            currentMode = Mode::Piano;
+        else if (currentMode == Mode::Piano && hosted)
+            currentMode = Mode::Instrument;
+        else if (currentMode != Mode::Session)
+            currentMode = Mode::Session;
+        else
+            currentMode = Mode::Drum;
+        printMode();
+    }
 
-        buffer[i] = (float)(tanh(sample * 1.25) * 0.3);
+    if (c == '\t') {
+        std::cout << "\ncallback timing (rt "
+                  << (rtHardening ? "on" : "off") << "):\n";
+        callbackTimes.print(std::cout,
+                            1e6 * audio.periodFrames / SAMPLE_RATE);
+        std::cout << "  xruns " << backend.xruns() << "\n";
+
+        AudioLatency latency = backend.latency();
+        std::cout << "key -> callback (then + "
+                  << (latency.reported ? latency.outputMs : latency.bufferMs)
+                  << " ms output):\n";
+        inputLatency.print(std::cout,
+                           1e6 * audio.periodFrames / SAMPLE_RATE, "keys");
+        if (osc.running()) {
+            std::cout << "osc: " << osc.packets() << " packets, "
+                      << osc.events() << " events, " << osc.dropped()
+                      << " dropped, " << osc.malformed() << " not understood; "
+                         "arrival -> callback:\n";
+            oscLatency.print(std::cout,
+                             1e6 * audio.periodFrames / SAMPLE_RATE, "events");
+        }
+        if (piano->lazy)
+            std::cout << "piano: " << piano->notesComplete() << " of "
+                      << piano->notes.size() << " notes complete, "
+                      << piano->renderedBytes() / 1024 << " KiB rendered, "
+                      << pianoVoices.starvedFrames.load() << " frames starved\n";
+        printChannels(std::cout, 1e6 * audio.periodFrames / SAMPLE_RATE);
+        if (jobs) jobs->print(std::cout);
+        if (analyzer.running())
+            std::cout << "analysis: " << analyzer.frames() << " frames, "
+                      << analyzer.dropped() << " samples dropped\n";
     }
-}
 
+    Mode mode = currentMode;
 
+    if (const Keymap* keys = keymap(CH_DRUMS, mode)) {
+        int drum = keys->at(c);
+        if (drum == DRUM_KICK) kickHits.push({ 36, 1.0f });
+        if (drum == DRUM_SNARE) trigger(snare, SRC_SNARE, CHOKE_SNARE);
+        if (drum == DRUM_HAT) trigger(hihat, SRC_HAT, CHOKE_HATS);
+        if (drum == DRUM_OPEN_HAT) trigger(openHat, SRC_OPEN_HAT, CHOKE_HATS);
+        sounded |= drum >= 0;
+    }
 
 
-double pianoFreqs[MAX_PIANO_NOTES] = {
-    261.63, // C
-    277.18, // C#
-    293.66, // D
-    311.13, // D#
-    329.63, // E
-    349.23, // F
-    369.99, // F#
-    392.00, // G
-    415.30, // G#
-    440.00, // A
-    466.16, // A#
-    493.88, // B
-    523.25, // C
-    554.37, // C#
-    587.33, // D
-    622.25, // D#
-    659.25, // E
-    698.46, // F
-    739.99, // F#
-    783.99,  // G
-    
-};
+    if (const Keymap* keys = keymap(CH_PIANO, mode)) {
 
+        if (c == 'D' || c == 'C') {
+            octave = c == 'D' ? std::max(-2, octave - 1)
+                              : std::min(2, octave + 1);
+            if (renderOctaves) {
+                regeneratePiano();
+            } else {
+                livePianoStep.store(pianoStep(), std::memory_order_relaxed);
+                std::cout << "Octave: " << octave << "\n";
+            }
+        }
 
+        if (c >= '1' && c <= '9') {
+            velocity = (c - '0') / 9.0;
+            std::cout << "Velocity: " << c << "\n";
+        }
 
+        if (c == ' ')
+            setSustainPedal(!sustainPedal);
 
-void regeneratePiano() {
-    for (int i = 0; i < MAX_PIANO_NOTES; i++) {
-        generatePianoNote(
-            piano[i],
-            pianoFreqs[i] * pow(2.0, octave),
-            sustainPedal
-        );
+        int note = keys->at(c);
+        if (note >= 0) {
+            piano->play(pianoTriggers, pianoSources(piano), note, velocity,
+                        pianoStep());
+            heldPianoKey[c] = note + 1;
+            heldPianoBase[c] = pianoSources(piano);
+            sounded = true;
+        }
     }
-}
 
 
+    if (const Keymap* keys = keymap(CH_HOSTED, mode)) {
+        if (c >= '1' && c <= '9')
+            velocity = (c - '0') / 9.0;
 
+        // piano keys starting at C4, shifted by the octave keys
+        if (c == 'D') hostedOctave = std::max(-3, hostedOctave - 1);
+        if (c == 'C') hostedOctave = std::min(3, hostedOctave + 1);
 
-// =====================
-// AUDIO CALLBACK
-// =====================
-static int audioCallback(
-    const void*,
-    void* output,
-    unsigned long frameCount,
-    const PaStreamCallbackTimeInfo*,
-    PaStreamCallbackFlags,
-    void*
-) {
-    float* out = (float*)output;
-
-    for (unsigned long i = 0; i < frameCount; i++) {
-        float mix = 0.0f;
-
-        int p;
-
-        p = snarePH.load();
-        if (p >= 0 && p < SNARE_N) {
-            mix += snare[p];
-            snarePH.fetch_add(1);
+        // live controllers, for instruments that take them
+        if (c == '-' || c == '=') {
+            hostedBrightness = std::clamp(
+                hostedBrightness + (c == '=' ? 0.125f : -0.125f), 0.0f, 1.0f);
+            hostedControls.push({ 74, hostedBrightness });
+            std::cout << "Brightness: " << hostedBrightness << "\n";
         }
-
-        p = kickPH.load();
-        if (p >= 0 && p < KICK_N) {
-            mix += kick[p];
-            kickPH.fetch_add(1);
+        if (c == ',' || c == '.') {
+            hostedModWheel = std::clamp(
+                hostedModWheel + (c == '.' ? 0.125f : -0.125f), 0.0f, 1.0f);
+            hostedControls.push({ 1, hostedModWheel });
+            std::cout << "Mod wheel: " << hostedModWheel << "\n";
         }
 
-        p = hatPH.load();
-        if (p >= 0 && p < HAT_N) {
-            mix += hihat[p];
-            hatPH.fetch_add(1);
+        int key = keys->at(c);
+        if (key >= 0) {
+            int note = 60 + 12 * hostedOctave + key;
+            hostedNotes.push({ note, float(velocity) });
+            heldNote[c] = note + 1;
+            sounded = true;
         }
-
-        for (int n = 0; n < MAX_PIANO_NOTES; n++) {
-            int p = pianoPH[n].load();
-            if (p >= 0 && p < PIANO_N) {
-                mix += piano[n][p];
-                pianoPH[n].fetch_add(1);
-            }
-        }
-
-
-        out[i] = tanh(mix * 0.8f);
     }
 
-    return paContinue;
+    if (sounded)
+        keyStamps.push(e.timeNs);
 }
 
 // =====================
-// RAW KEYBOARD
+// MAIN
 // =====================
-char readChar() {
-    char c;
-    read(STDIN_FILENO, &c, 1);
-    return c;
-}
-
-void setRawMode(bool enable) {
-    static termios oldt;
-    termios newt;
-
-    if (enable) {
-        tcgetattr(STDIN_FILENO, &oldt);
-        newt = oldt;
-        newt.c_lflag &= ~(ICANON | ECHO);
-        tcsetattr(STDIN_FILENO, TCSANOW, &newt);
-    } else {
-        tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
-    }
+void usage() {
+    std::cerr <<
+        "usage: synth [--format f32|i16|bfp8] [--layers N] [--variants N]\n"
+        "             [--model additive|waveguide] [--instrument NAME]\n"
+        "             [--eager-piano | --warm-piano] [--render-octaves]\n"
+        "             [--snare FILE.wav] [--hat FILE.wav] [--session] [--no-rt]\n"
+        "             [--backend NAME] [--device DEV] [--period N] "
+        "[--periods N]\n"
+        "             [--input auto|evdev|stdin|script] [--input-device PATH]\n"
+        "             [--analyze FILE|-|udp:HOST:PORT] [--osc [HOST:]PORT]\n"
+        "instruments:";
+    for (const InstrumentInfo& info : INSTRUMENTS)
+        std::cerr << " " << info.name;
+    std::cerr << "\nbackends:\n";
+    for (const BackendInfo& info : BACKENDS)
+        std::cerr << "  " << info.name << " - " << info.description << "\n";
 }
 
-// =====================
-// MAIN
-// =====================
-int main() {
-    generateSnare();
-    generateKick();
-    generateHiHat();
-    for (int i = 0; i < MAX_PIANO_NOTES; i++) {
-        pianoPH[i] = -1;
-        generatePianoNote(piano[i], pianoFreqs[i], false);
+int main(int argc, char** argv) {
+    SampleFormat format = SampleFormat::Float32;
+    int layers = 1;
+    int variants = 1;
+    PianoModel model = PianoModel::Waveguide;
+    bool eagerPiano = false;
+    bool warmPiano = false;
+    const BackendInfo* backendInfo = &BACKENDS[0];
+    AudioConfig audio;
+    audio.sampleRate = SAMPLE_RATE;
+    std::string inputKind = "auto";
+    std::string inputDevice;
+    std::string analyzeDest;
+    std::string oscWhere;
+    std::string snareWav, hatWav;
+
+    for (int i = 1; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if (value && strcmp(argv[i], "--format") == 0
+            && parseFormat(value, format)) {
+            i++;
+        } else if (value && strcmp(argv[i], "--layers") == 0) {
+            layers = atoi(value);
+            i++;
+        } else if (value && strcmp(argv[i], "--variants") == 0) {
+            variants = atoi(value);
+            i++;
+        } else if (value && strcmp(argv[i], "--model") == 0
+                   && (strcmp(value, "additive") == 0
+                       || strcmp(value, "waveguide") == 0)) {
+            model = strcmp(value, "additive") == 0
+                ? PianoModel::Additive
+                : PianoModel::Waveguide;
+            i++;
+        } else if (value && strcmp(argv[i], "--instrument") == 0
+                   && findInstrument(value)) {
+            hosted = findInstrument(value)->create();
+            hosted->prepare(SAMPLE_RATE, MAX_BLOCK);
+            i++;
+        } else if (value && strcmp(argv[i], "--backend") == 0
+                   && findBackend(value)) {
+            backendInfo = findBackend(value);
+            i++;
+        } else if (value && strcmp(argv[i], "--device") == 0) {
+            audio.device = value;
+            i++;
+        } else if (value && strcmp(argv[i], "--period") == 0) {
+            audio.periodFrames = std::max(16, atoi(value));
+            i++;
+        } else if (value && strcmp(argv[i], "--periods") == 0) {
+            audio.periods = std::max(2, atoi(value));
+            i++;
+        } else if (value && strcmp(argv[i], "--input") == 0
+                   && (strcmp(value, "auto") == 0
+                       || strcmp(value, "evdev") == 0
+                       || strcmp(value, "stdin") == 0
+                       || strcmp(value, "script") == 0)) {
+            inputKind = value;
+            i++;
+        } else if (value && strcmp(argv[i], "--input-device") == 0) {
+            inputDevice = value;
+            i++;
+        } else if (value && strcmp(argv[i], "--analyze") == 0) {
+            analyzeDest = value;
+            i++;
+        } else if (value && strcmp(argv[i], "--osc") == 0) {
+            oscWhere = value;
+            i++;
+        } else if (value && strcmp(argv[i], "--snare") == 0) {
+            snareWav = value;
+            i++;
+        } else if (value && strcmp(argv[i], "--hat") == 0) {
+            hatWav = value;
+            i++;
+        } else if (strcmp(argv[i], "--session") == 0) {
+            currentMode = Mode::Session;
+        } else if (strcmp(argv[i], "--render-octaves") == 0) {
+            renderOctaves = true;
+        } else if (strcmp(argv[i], "--eager-piano") == 0) {
+            eagerPiano = true;
+        } else if (strcmp(argv[i], "--warm-piano") == 0) {
+            warmPiano = true;
+        } else if (strcmp(argv[i], "--no-rt") == 0) {
+            rtHardening = false;
+        } else {
+            usage();
+            return 1;
+        }
     }
 
+    if (!renderDrums(snareWav, hatWav))
+        return 1;
+    preparePitch();
 
-    Pa_Initialize();
-
-    PaStream* stream;
-    Pa_OpenDefaultStream(
-        &stream,
-        0,
-        1,
-        paFloat32,
-        SAMPLE_RATE,
-        256,
-        audioCallback,
-        nullptr
-    );
-
-    Pa_StartStream(stream);
-
-    std::cout <<
-        "j = snare | space = kick | f = hi-hat\n"
-        "Ctrl+C to exit\n";
-
-    setRawMode(true);
-
-    while (true) {
-        char c = readChar();
-
-        if (c == '\n') {
-            currentMode = (currentMode == Mode::Drum)
-                ? Mode::Piano
-                : Mode::Drum;
+    // a re-render holds a worker throughout; one more keeps the live
+    // bank's render-ahead going meanwhile
+    if (!eagerPiano || renderOctaves) {
+        int cores = int(std::thread::hardware_concurrency());
+        jobs = std::make_unique<Scheduler>(
+            std::clamp(cores - 1, 1, MAX_JOB_THREADS) + renderOctaves);
+    }
 
-            std::cout << (currentMode == Mode::Drum
-                ? "\n[ DRUM MODE ]\n"
-                : "\n[ PIANO MODE ]\n");
+    auto pianoStart = std::chrono::steady_clock::now();
+    for (PianoBank& bank : pianoBanks) {
+        if (&bank != piano && !renderOctaves) break;
+        bank.allocate(format, layers, variants,
+                      eagerPiano ? nullptr : jobs.get());
+        bank.model = model;
+        bank.warm = warmPiano;
+    }
+    piano->render(1.0);
+    double pianoMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - pianoStart).count();
+
+    std::cout << "piano bank: " << formatName(piano->format) << ", "
+              << piano->layers << " layer(s) x " << piano->variants
+              << " variant(s), " << piano->bytes() / 1024 << " KiB ("
+              << piano->bytes() / piano->layers / 1024
+              << " KiB per layer), "
+              << (renderOctaves ? "double-buffered, rendered per octave"
+                                : "pitched for other octaves") << "\n"
+              << std::fixed << std::setprecision(1) << "piano: "
+              << (piano->lazy ? "attacks" : "all notes") << " rendered in "
+              << pianoMs << " ms, " << piano->renderedBytes() / 1024
+              << " KiB" << (!piano->lazy ? ""
+                            : piano->warm ? ", the rest in the background"
+                                          : ", the rest as keys are played")
+              << "\n";
+
+    if (!analyzeDest.empty()) {
+        std::string error;
+        std::unique_ptr<AnalysisSink> sink = openAnalysisSink(analyzeDest, error);
+        if (!sink) {
+            std::cerr << "analysis: " << error << "\n";
+            return 1;
         }
+        analyzer.start(std::move(sink), SAMPLE_RATE);
+        std::cout << "analysis: spectra and levels to " << analyzeDest << "\n";
+    }
 
-         // D or C
-
-        
+    blockScratch.allocate(BLOCK_SCRATCH_BYTES);
+
+    // everything the callback reads is allocated by now
+    if (rtHardening) {
+        rt.memoryLocked = lockMemory(!eagerPiano);
+        for (const PianoBank& bank : pianoBanks)
+            for (const SampleBuffer& s : bank.notes)
+                rt.prefaultedBytes += prefaultSamples(s);
+        rt.prefaultedBytes += prefaultSamples(snare);
+        rt.prefaultedBytes += prefaultSamples(hihat);
+        rt.prefaultedBytes += prefaultSamples(openHat);
+        rt.prefaultedBytes += prefault(&kick, sizeof(kick));
+        rt.prefaultedBytes += prefault(&drumVoices, sizeof(drumVoices));
+        rt.prefaultedBytes += prefault(&pianoVoices, sizeof(pianoVoices));
+    }
 
-        if (currentMode == Mode::Drum) {
-            if (c == 'j') snarePH = 0;
-            if (c == ' ') kickPH  = 0;
-            if (c == 'f') hatPH   = 0;
+    if (!oscWhere.empty()) {
+        std::string error;
+        if (!osc.open(oscWhere, error)) {
+            std::cerr << error << "\n";
+            return 1;
         }
+    }
 
+    std::unique_ptr<AudioBackend> backend = backendInfo->create();
+    if (!backend->open(audio, renderAudio) || !backend->start()) {
+        std::cerr << backend->name() << ": " << backend->error() << "\n";
+        return 1;
+    }
+    streaming = true;
 
-        if (currentMode == Mode::Piano) {
+    if (!oscWhere.empty()) {
+        osc.start(oscEvents);
+        std::cout << "osc: listening on udp port " << osc.port()
+                  << " (/drum/snare|kick|hat|openhat, /piano, /note, /cc, /pedal)\n";
+    }
 
-            if (c == 'D') {
-                octave = std::max(-2, octave - 1);
-                regeneratePiano();
-                std::cout << "Octave: " << octave << "\n";
-            }
-            else if (c == 'C') {
-                octave = std::min(2, octave + 1);
-                regeneratePiano();
-                std::cout << "Octave: " << octave << "\n";
-            }
+    // the audio thread sets its half of the report on its first callback
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    if (rtHardening) rt.print(std::cout);
+    else std::cout << "rt: hardening off (--no-rt)\n";
+
+    AudioLatency latency = backend->latency();
+    std::cout << std::fixed << std::setprecision(1)
+              << "audio: " << backend->name() << ", "
+              << latency.periodFrames << " frames x " << latency.periods
+              << " period(s), buffer " << latency.bufferMs << " ms, output "
+              << (latency.reported ? latency.outputMs : latency.bufferMs)
+              << " ms" << (latency.reported ? "" : " (estimated)")
+              << ", key-to-sound <= "
+              << latency.worstKeyToSoundMs(SAMPLE_RATE) << " ms\n";
 
-            switch (c) {
-                case 'a': pianoPH[0] = 0; break;
-                case 'w': pianoPH[1] = 0; break;
-                case 's': pianoPH[2] = 0; break;
-                case 'e': pianoPH[3] = 0; break;
-                case 'd': pianoPH[4] = 0; break;
-                case 'f': pianoPH[5] = 0; break;
-                case 't': pianoPH[6] = 0; break;
-                case 'g': pianoPH[7] = 0; break;
-                case 'y': pianoPH[8] = 0; break;
-                case 'h': pianoPH[9] = 0; break;
-                case 'u': pianoPH[10] = 0; break;
-                case 'j': pianoPH[11] = 0; break;
-                case 'k': pianoPH[12] = 0; break;
-                case 'o': pianoPH[13] = 0; break;
-                case 'l': pianoPH[14] = 0; break;
-                case 'p': pianoPH[15] = 0; break;
-                case ';': pianoPH[16] = 0; break;
-                case '\'': pianoPH[17] = 0; break;
-                case ']': pianoPH[18] = 0; break;
-                case '\\': pianoPH[19] = 0; break;
-            }
-        }
+    std::cout <<
+        "j = snare | space = kick | f = hi-hat | d = open hi-hat\n"
+        "Enter = next mode (drums, piano, instrument, all at once)\n"
+        "Tab = callback timing, input latency, channels and background jobs\n"
+        "Ctrl+C to exit\n";
+    if (currentMode == Mode::Session)
+        printMode();
+
+    std::unique_ptr<InputSource> input = openInput(inputKind, inputDevice);
+    if (!input) {
+        std::cerr << "input: cannot open " << inputKind
+                  << (inputDevice.empty() ? "" : " " + inputDevice) << "\n";
+        backend->stop();
+        return 1;
+    }
+    std::cout << "input: " << input->name()
+              << (input->hasKeyUp() ? " (key up" : " (key down only")
+              << (strcmp(input->name(), "evdev") == 0 ? ", kernel timestamps)"
+                                                     : ")") << "\n";
 
+    setRawMode(true);
 
+    KeyEvent events[64];
+    for (;;) {
+        // polled while a spare renders, so it is adopted once it is done
+        adoptPiano();
+        bool pending = spareRendering || spareRendered;
+        int n = input->poll(events, 64, pending ? 10 : -1);
+        if (n < 0) break;
+        for (int i = 0; i < n; i++)
+            handleKey(events[i], *backend, audio);
     }
 
+    // evdev keys also went to the terminal; do not leave them to the shell
+    tcflush(STDIN_FILENO, TCIFLUSH);
     setRawMode(false);
-    Pa_StopStream(stream);
-    Pa_Terminate();
+    osc.stop();
+    backend->stop();
+    while (spareRendering)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    for (PianoBank& bank : pianoBanks)
+        bank.stopAhead();
+    analyzer.stop();
 }
@@ -0,0 +1,311 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+#include "resampler.h"
+#include "samples.h"
+#include "spsc_queue.h"
+
+// =====================
+// VOICES
+// =====================
+// Every sound the mixer plays is a one-shot read through a pre-rendered
+// SampleBuffer. The voice state is kept as a structure of arrays so the
+// mixer walks each field linearly, and active voices are packed at the
+// front so an idle engine touches nothing. Only the audio thread writes it;
+// everyone else goes through TriggerQueue.
+constexpr int MAX_VOICES = 32;
+constexpr int MAX_BLOCK  = 512;
+
+// Note-off and the sustain pedal are handled here rather than baked into
+// the buffers. A voice may carry a second rendering of the same note with
+// the pedal down (`pedalTail`, same length and timing); the mixer
+// crossfades between the two over PEDAL_FADE_FRAMES whenever the pedal
+// moves. A released voice with the pedal up fades out exponentially
+// (time constant RELEASE_FRAMES) and is dropped once inaudible. Gains are
+// ramped across each block, so none of this clicks.
+constexpr int PEDAL_FADE_FRAMES = 3528;  // ~80 ms at 44.1 kHz
+constexpr int RELEASE_FRAMES    = 2205;  // ~50 ms time constant
+constexpr float RELEASE_FLOOR   = 1e-4f; // -80 dB
+
+// Choke groups: a Start in group g fades out every voice already
+// sounding in g over CHOKE_FRAMES, and takes a voice of its own rather
+// than restarting one in place (which jumps from mid-sound to the
+// attack, and clicks). A closed hi-hat chokes the open one that way, and
+// a drum in a group of its own chokes its previous hit. Group 0 chokes
+// nothing and retriggers in place. The fade is a gain ramp like the
+// others, so a voice pays for it per block, and only while choked.
+constexpr int CHOKE_FRAMES = 220;  // ~5 ms
+
+// A voice can also play its buffer at another pitch, `step` buffer
+// frames per output frame (2 = an octave up), read through the
+// windowed-sinc resampler. Steps are kept within MAX_PITCH_STEP either
+// way; a step of exactly 1 is the plain copy and costs nothing extra.
+constexpr float MAX_PITCH_STEP = 4.0f;    // two octaves
+constexpr int PITCH_SPAN = int(MAX_PITCH_STEP) * MAX_BLOCK
+                         + 2 * RESAMPLE_HALF * int(MAX_PITCH_STEP) + 8;
+
+// The kernel for `step`: one per power of two, so an octave step gets
+// one of its own and anything between is cut to the next octave up.
+// Built on first use; call preparePitch() before the audio thread runs.
+inline const ResampleKernel& pitchKernel(float step) {
+    if (step <= 1.0f) { static const ResampleKernel k(1.0); return k; }
+    if (step <= 2.0f) { static const ResampleKernel k(2.0); return k; }
+    static const ResampleKernel k(MAX_PITCH_STEP);
+    return k;
+}
+
+inline void preparePitch() {
+    for (float step = 1.0f; step <= MAX_PITCH_STEP; step *= 2.0f)
+        pitchKernel(step);
+}
+
+struct VoiceBank {
+    alignas(64) const SampleBuffer* sample[MAX_VOICES];
+    alignas(64) const SampleBuffer* pedalTail[MAX_VOICES];  // or null
+    alignas(64) int position[MAX_VOICES];
+    alignas(64) float frac[MAX_VOICES];   // ... and the fraction past it
+    alignas(64) float step[MAX_VOICES];   // 1 = as rendered
+    alignas(64) int length[MAX_VOICES];
+    alignas(64) float gain[MAX_VOICES];
+    alignas(64) float env[MAX_VOICES];    // release envelope, 1 while held
+    alignas(64) float blend[MAX_VOICES];  // 0 = sample, 1 = pedalTail
+    alignas(64) int source[MAX_VOICES];
+    alignas(64) bool held[MAX_VOICES];
+    alignas(64) uint8_t group[MAX_VOICES];  // choke group, 0 = none
+    alignas(64) int chokeLeft[MAX_VOICES];  // frames of fade, 0 = not choked
+    int active = 0;
+    bool pedal = false;
+
+    // frames a voice reached before its buffer was written (see
+    // SampleBuffer::ready) and played as silence
+    std::atomic<uint64_t> starvedFrames{ 0 };
+
+    float pitchInput[PITCH_SPAN];  // a pitched voice's block, decoded
+};
+
+// A request to the mixer. `source` identifies what is being played (a
+// drum, a piano key).
+//
+//   Start    (re)start `sample` on the source; retriggering restarts its
+//            voice instead of stacking a new one, same as the old
+//            per-sound playheads. A null `sample` silences the source.
+//   Release  note-off: the source's voice rings on while the pedal is
+//            down, else fades out.
+//   Pedal    sustain pedal down (gain > 0) or up; `source` is unused.
+//
+// `step` pitches a Start (see MAX_PITCH_STEP) and `choke` puts it in a
+// choke group (see CHOKE_FRAMES).
+struct Trigger {
+    enum Op : uint8_t { Start, Release, Pedal };
+
+    const SampleBuffer* sample;
+    float gain;
+    int source;
+    const SampleBuffer* pedalTail = nullptr;
+    Op op = Start;
+    float step = 1.0f;
+    uint8_t choke = 0;
+};
+
+using TriggerQueue = SpscQueue<Trigger>;
+
+inline void removeVoice(VoiceBank& v, int i) {
+    int last = --v.active;
+    v.sample[i]    = v.sample[last];
+    v.pedalTail[i] = v.pedalTail[last];
+    v.position[i]  = v.position[last];
+    v.frac[i]      = v.frac[last];
+    v.step[i]      = v.step[last];
+    v.length[i]    = v.length[last];
+    v.gain[i]      = v.gain[last];
+    v.env[i]       = v.env[last];
+    v.blend[i]     = v.blend[last];
+    v.source[i]    = v.source[last];
+    v.held[i]      = v.held[last];
+    v.group[i]     = v.group[last];
+    v.chokeLeft[i] = v.chokeLeft[last];
+}
+
+// Applies a Trigger (named for its common case).
+inline void startVoice(VoiceBank& v, const Trigger& t) {
+    if (t.op == Trigger::Pedal) {
+        v.pedal = t.gain > 0.0f;
+        return;
+    }
+
+    // a choked voice is on its way out and no longer its source's
+    int slot = -1;
+    for (int i = 0; i < v.active; i++) {
+        if (v.source[i] == t.source && !v.chokeLeft[i]) {
+            slot = i;
+            break;
+        }
+    }
+
+    if (t.op == Trigger::Release) {
+        if (slot >= 0) v.held[slot] = false;
+        return;
+    }
+
+    if (!t.sample) {
+        if (slot >= 0) removeVoice(v, slot);
+        return;
+    }
+
+    if (t.choke) {
+        for (int i = 0; i < v.active; i++)
+            if ((v.group[i] == t.choke || i == slot) && !v.chokeLeft[i])
+                v.chokeLeft[i] = CHOKE_FRAMES;
+        slot = -1;
+    }
+
+    if (slot < 0) {
+        if (v.active < MAX_VOICES) {
+            slot = v.active++;
+        } else {
+            // steal the voice that has been playing longest
+            slot = 0;
+            for (int i = 1; i < v.active; i++)
+                if (v.position[i] > v.position[slot]) slot = i;
+        }
+    }
+
+    v.sample[slot]    = t.sample;
+    v.pedalTail[slot] = t.pedalTail;
+    v.position[slot]  = 0;
+    v.frac[slot]      = 0.0f;
+    v.step[slot]      = std::clamp(t.step, 1.0f / MAX_PITCH_STEP, MAX_PITCH_STEP);
+    v.length[slot]    = t.sample->length;
+    v.gain[slot]      = t.gain;
+    v.env[slot]       = 1.0f;
+    v.blend[slot]     = v.pedal && t.pedalTail ? 1.0f : 0.0f;
+    v.source[slot]    = t.source;
+    v.held[slot]      = true;
+    v.group[slot]     = t.choke;
+    v.chokeLeft[slot] = 0;
+}
+
+// =====================
+// MIXER
+// =====================
+// How many of the `n` frames from `pos` on are written in `s`.
+inline int readable(const SampleBuffer* s, int pos, int n) {
+    if (!s || !s->ready) return n;
+    return std::clamp(s->ready->load(std::memory_order_acquire) - pos, 0, n);
+}
+
+// Frames [from, from + n) of `s` as floats, zero outside [0, end).
+inline void decodeRange(const SampleBuffer& s, int from, int n, int end,
+                        float* out) {
+    std::fill(out, out + n, 0.0f);
+    int lo = std::max(from, 0), hi = std::min(from + n, end);
+    if (hi > lo) mixSamples(s, lo, hi - lo, 1.0f, out + (lo - from));
+}
+
+// mixSamples for pitched voice `i`: `n` output frames of `s`, of which
+// the first `end` frames can be read.
+inline void mixPitched(VoiceBank& v, int i, const SampleBuffer& s, int end,
+                       int n, float gain, float* mix, float gainStep) {
+    if (n <= 0) return;
+    const ResampleKernel& k = pitchKernel(v.step[i]);
+    int first = v.position[i] - k.half() + 1;
+    int span = int(v.frac[i] + (n - 1) * double(v.step[i])) + k.taps();
+    decodeRange(s, first, span, end, v.pitchInput);
+    k.mix(v.pitchInput + k.half() - 1, v.frac[i], v.step[i], n, gain, mix,
+          gainStep);
+}
+
+// Adds `frames` (<= MAX_BLOCK) samples of every active voice into `mix`.
+// Each voice is one contiguous decode-gain-add run (see mixSamples), two
+// while it crossfades to or from its pedal tail. Envelope and crossfade
+// move once per block and are ramped across it; a held voice with the
+// pedal where it was has a constant gain. A voice that catches up with
+// a buffer still being written goes silent for the rest of the block
+// but keeps its time. A pitched voice decodes what the block spans and
+// resamples it; position and length stay in buffer frames. A choked one
+// fades to silence over what is left of CHOKE_FRAMES and is dropped.
+inline void mixVoices(VoiceBank& v, float* mix, int frames) {
+    for (int i = 0; i < v.active; ) {
+        bool pitched = v.step[i] != 1.0f;
+        int n, m, end = v.length[i];
+        if (!pitched) {
+            n = std::min(frames, v.length[i] - v.position[i]);
+            m = std::min(readable(v.sample[i], v.position[i], n),
+                         readable(v.pedalTail[i], v.position[i], n));
+        } else {
+            // output frames until the end, and those whose taps are all
+            // written (past the end is silence, so that counts)
+            double t = v.frac[i], step = v.step[i];
+            int left = v.length[i] - v.position[i];
+            n = std::min(frames, int(ceil((left - t) / step)));
+            int have = std::min(readable(v.sample[i], v.position[i], left),
+                                readable(v.pedalTail[i], v.position[i], left));
+            int reach = pitchKernel(v.step[i]).half();
+            m = have == left ? n
+                : std::clamp(int((have - reach - t) / step), 0, n);
+            end = v.position[i] + have;
+        }
+
+        // a choked voice plays out the rest of its fade, then goes
+        int choke = v.chokeLeft[i];
+        if (choke) {
+            n = std::min(n, choke);
+            m = std::min(m, n);
+        }
+        if (m < n)
+            v.starvedFrames.fetch_add(uint64_t(n - m), std::memory_order_relaxed);
+
+        bool damped = !v.held[i] && !v.pedal;
+        float env0 = v.env[i];
+        float env1 = damped ? env0 * expf(-float(n) / RELEASE_FRAMES) : env0;
+
+        float blend0 = v.blend[i];
+        float blend1 = blend0;
+        if (v.pedalTail[i]) {
+            float fade = float(n) / PEDAL_FADE_FRAMES;
+            blend1 = v.pedal ? std::min(1.0f, blend0 + fade)
+                             : std::max(0.0f, blend0 - fade);
+        }
+
+        float g0 = v.gain[i] * env0, g1 = v.gain[i] * env1;
+        if (choke) {
+            g0 *= float(choke) / CHOKE_FRAMES;
+            g1 *= float(choke - n) / CHOKE_FRAMES;
+            v.chokeLeft[i] = choke - n;
+        }
+        if (blend0 < 1.0f || blend1 < 1.0f) {
+            float a = g0 * (1.0f - blend0), b = g1 * (1.0f - blend1);
+            if (pitched)
+                mixPitched(v, i, *v.sample[i], end, m, a, mix, (b - a) / n);
+            else
+                mixSamples(*v.sample[i], v.position[i], m, a, mix, (b - a) / n);
+        }
+        if (blend0 > 0.0f || blend1 > 0.0f) {
+            float a = g0 * blend0, b = g1 * blend1;
+            if (pitched)
+                mixPitched(v, i, *v.pedalTail[i], end, m, a, mix, (b - a) / n);
+            else
+                mixSamples(*v.pedalTail[i], v.position[i], m, a, mix, (b - a) / n);
+        }
+
+        v.env[i] = env1;
+        v.blend[i] = blend1;
+        if (!pitched) {
+            v.position[i] += n;
+        } else {
+            double to = v.frac[i] + n * double(v.step[i]);
+            int whole = int(to);
+            v.position[i] += whole;
+            v.frac[i] = float(to - whole);
+        }
+        if (v.position[i] >= v.length[i] || env1 < RELEASE_FLOOR
+            || (choke && v.chokeLeft[i] == 0))
+            removeVoice(v, i);
+        else
+            i++;
+    }
+}
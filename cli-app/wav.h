@@ -0,0 +1,236 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+// =====================
+// WAV OUTPUT
+// =====================
+// 16-bit mono PCM. Samples are clamped to [-1, 1].
+//
+// WavWriter streams: the header goes out with zero sizes and is patched
+// by updateHeader() / close(), so a file cut short still has the length
+// of the last update.
+class WavWriter {
+public:
+    ~WavWriter() { close(); }
+
+    bool open(const char* filename, int sampleRate) {
+        file_.open(filename, std::ios::binary);
+        if (!file_) return false;
+        rate_ = sampleRate;
+        samples_ = 0;
+        writeHeader();
+        return bool(file_);
+    }
+
+    bool write(const float* samples, int n) {
+        for (int i = 0; i < n; i++) {
+            float x = std::clamp(samples[i], -1.0f, 1.0f);
+            int16_t s = (int16_t)lrintf(x * 32767.0f);
+            file_.write((const char*)&s, 2);
+        }
+        samples_ += n;
+        return bool(file_);
+    }
+
+    void updateHeader() {
+        if (!file_.is_open()) return;
+        auto end = file_.tellp();
+        file_.seekp(0);
+        writeHeader();
+        file_.seekp(end);
+        file_.flush();
+    }
+
+    bool close() {
+        if (!file_.is_open()) return true;
+        updateHeader();
+        bool ok = bool(file_);
+        file_.close();
+        return ok;
+    }
+
+private:
+    void writeHeader() {
+        int32_t subchunk2Size = int32_t(samples_ * 2);
+        int32_t chunkSize = 36 + subchunk2Size;
+        int32_t rate = rate_;
+        int32_t byteRate = rate_ * 2;
+
+        // RIFF header
+        file_.write("RIFF", 4);
+        file_.write((const char*)&chunkSize, 4);
+        file_.write("WAVE", 4);
+
+        // fmt chunk
+        file_.write("fmt ", 4);
+        int32_t subchunk1Size = 16;
+        int16_t audioFormat = 1;
+        int16_t numChannels = 1;
+        int16_t bitsPerSample = 16;
+        int16_t blockAlign = numChannels * bitsPerSample / 8;
+
+        file_.write((const char*)&subchunk1Size, 4);
+        file_.write((const char*)&audioFormat, 2);
+        file_.write((const char*)&numChannels, 2);
+        file_.write((const char*)&rate, 4);
+        file_.write((const char*)&byteRate, 4);
+        file_.write((const char*)&blockAlign, 2);
+        file_.write((const char*)&bitsPerSample, 2);
+
+        // data chunk
+        file_.write("data", 4);
+        file_.write((const char*)&subchunk2Size, 4);
+    }
+
+    std::ofstream file_;
+    int rate_ = 44100;
+    int64_t samples_ = 0;
+};
+
+inline bool writeWav(const char* filename, const float* samples,
+                     int numSamples, int sampleRate) {
+    WavWriter wav;
+    return wav.open(filename, sampleRate)
+        && wav.write(samples, numSamples)
+        && wav.close();
+}
+
+// =====================
+// WAV INPUT
+// =====================
+// WavReader streams a PCM (16, 24 or 32 bit) or 32-bit float WAV, plain
+// or WAVE_FORMAT_EXTENSIBLE, any channel count, as floats a chunk at a
+// time; it can seek, so several readers can work on one file. Integer
+// samples are scaled by the largest positive value, as writeWav does.
+class WavReader {
+public:
+    // False if the file is not a WAV this reads.
+    bool open(const char* filename) {
+        file_.open(filename, std::ios::binary);
+        char id[4];
+        uint32_t size;
+        if (!file_.read(id, 4) || memcmp(id, "RIFF", 4) != 0) return false;
+        file_.read((char*)&size, 4);
+        if (!file_.read(id, 4) || memcmp(id, "WAVE", 4) != 0) return false;
+
+        uint16_t format = 0;
+        while (file_.read(id, 4) && file_.read((char*)&size, 4)) {
+            if (memcmp(id, "fmt ", 4) == 0) {
+                std::vector<char> fmt(size);
+                file_.read(fmt.data(), size);
+                if (size < 16) return false;
+                uint16_t channels, bits;
+                uint32_t rate;
+                memcpy(&format, &fmt[0], 2);
+                memcpy(&channels, &fmt[2], 2);
+                memcpy(&rate, &fmt[4], 4);
+                memcpy(&bits, &fmt[14], 2);
+                if (format == 0xFFFE && size >= 26)
+                    memcpy(&format, &fmt[24], 2);  // sub-format GUID
+                channels_ = channels;
+                rate_ = int(rate);
+                bytes_ = bits / 8;
+                isFloat_ = format == 3;
+            } else if (memcmp(id, "data", 4) == 0) {
+                bool pcm = format == 1 && (bytes_ == 2 || bytes_ == 3 || bytes_ == 4);
+                bool flt = format == 3 && bytes_ == 4;
+                if (!(pcm || flt) || channels_ < 1) return false;
+                dataStart_ = file_.tellg();
+                frames_ = int64_t(size) / (bytes_ * channels_);
+                return true;
+            } else {
+                file_.seekg(size + (size & 1), std::ios::cur);
+            }
+        }
+        return false;
+    }
+
+    int sampleRate() const { return rate_; }
+    int channels() const { return channels_; }
+    int64_t frames() const { return frames_; }
+
+    bool seek(int64_t frame) {
+        file_.clear();
+        file_.seekg(dataStart_ + std::streamoff(frame * bytes_ * channels_));
+        position_ = frame;
+        return bool(file_);
+    }
+
+    // Up to `n` frames as mono: the channels averaged, or only the first.
+    // Returns the frames read, 0 at the end.
+    int read(float* out, int n, bool firstChannel = false) {
+        n = int(std::min<int64_t>(n, frames_ - position_));
+        if (n <= 0) return 0;
+
+        int frameBytes = bytes_ * channels_;
+        raw_.resize(size_t(n) * frameBytes);
+        file_.read(raw_.data(), std::streamsize(raw_.size()));
+        n = int(file_.gcount() / frameBytes);
+        position_ += n;
+
+        int used = firstChannel ? 1 : channels_;
+        float scale = 1.0f / used;
+        for (int i = 0; i < n; i++) {
+            const char* frame = raw_.data() + size_t(i) * frameBytes;
+            float sum = 0.0f;
+            for (int c = 0; c < used; c++)
+                sum += sample(frame + c * bytes_);
+            out[i] = used == 1 ? sum : sum * scale;
+        }
+        return n;
+    }
+
+private:
+    float sample(const char* p) const {
+        if (isFloat_) {
+            float f;
+            memcpy(&f, p, 4);
+            return f;
+        }
+        switch (bytes_) {
+        case 2: {
+            int16_t v;
+            memcpy(&v, p, 2);
+            return v / 32767.0f;
+        }
+        case 3: {
+            int32_t v = int32_t(uint32_t(uint8_t(p[0])) << 8
+                                | uint32_t(uint8_t(p[1])) << 16
+                                | uint32_t(uint8_t(p[2])) << 24) >> 8;
+            return v / 8388607.0f;
+        }
+        default: {
+            int32_t v;
+            memcpy(&v, p, 4);
+            return float(v / 2147483647.0);
+        }
+        }
+    }
+
+    std::ifstream file_;
+    std::streampos dataStart_ = 0;
+    int64_t frames_ = 0;
+    int64_t position_ = 0;
+    int channels_ = 0;
+    int rate_ = 0;
+    int bytes_ = 0;
+    bool isFloat_ = false;
+    std::vector<char> raw_;
+};
+
+// The first channel of a whole file; false if WavReader cannot read it.
+inline bool readWav(const char* filename, std::vector<float>& samples,
+                    int* sampleRate = nullptr) {
+    WavReader wav;
+    if (!wav.open(filename)) return false;
+    samples.resize(size_t(wav.frames()));
+    samples.resize(size_t(wav.read(samples.data(), int(samples.size()), true)));
+    if (sampleRate) *sampleRate = wav.sampleRate();
+    return true;
+}
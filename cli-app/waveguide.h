@@ -0,0 +1,163 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+// =====================
+// WAVEGUIDE STRING
+// =====================
+// Single-loop (extended Karplus-Strong) string:
+//
+//   delay N -> loss one-pole * g -> M dispersion allpasses -> Thiran -> back
+//
+// The one-pole sets how much faster upper partials decay than the
+// fundamental, the allpass chain delays low frequencies more than high
+// ones so partials come out stretched like a stiff string, and the
+// first-order Thiran allpass supplies the fractional part of the loop
+// length. Cost per sample is fixed no matter how many partials ring.
+constexpr int WG_MAX_DELAY = 2048;   // ~21 Hz at 44.1 kHz
+constexpr int WG_DISPERSION = 4;
+
+struct Allpass1 {
+    double a = 0.0;
+    double x1 = 0.0, y1 = 0.0;
+
+    inline double process(double x) {
+        double y = a * x + x1 - a * y1;
+        x1 = x;
+        y1 = y;
+        return y;
+    }
+};
+
+// phase delays in samples at angular frequency w (rad/sample)
+inline double allpassDelay(double a, double w) {
+    std::complex<double> z1 = std::polar(1.0, -w);
+    return -std::arg((a + z1) / (1.0 + a * z1)) / w;
+}
+
+inline double onePoleDelay(double b, double w) {
+    std::complex<double> z1 = std::polar(1.0, -w);
+    return std::arg(1.0 - b * z1) / w;
+}
+
+inline double onePoleGain(double b, double w) {
+    std::complex<double> z1 = std::polar(1.0, -w);
+    return (1.0 - b) / std::abs(1.0 - b * z1);
+}
+
+struct WaveguideString {
+    float delay[WG_MAX_DELAY];
+    int length = 1;
+    int pos = 0;
+
+    double g = 1.0;       // loop gain
+    double b = 0.0;       // loss one-pole coefficient
+    double lp = 0.0;
+    Allpass1 dispersion[WG_DISPERSION];
+    Allpass1 tuning;
+
+    // Loop tuned so its first partial sits at f1 (Hz) and partial
+    // `refPartial` at the stiff-string position k (1 + B k^2) / (1 + B)
+    // relative to it. Partial k decays at roughly decayPerSec * k, same
+    // as the additive model.
+    void setup(double f1, double sampleRate, double B, int refPartial,
+               double decayPerSec) {
+        double w1 = 2.0 * M_PI * f1 / sampleRate;
+        int K = std::max(2, refPartial);
+        while (K > 2 && K * w1 > M_PI / 2) K--;
+
+        // --- dispersion: bisect the allpass coefficient on partial K ---
+        double target = K * (1.0 + B * K * K) / (1.0 + B);
+        double lo = -0.9, hi = 0.0;
+        double a = 0.0;
+        for (int it = 0; it < 30 && B > 0.0; it++) {
+            a = 0.5 * (lo + hi);
+            if (partialRatio(a, 0.0, w1, K) < target) hi = a;
+            else lo = a;
+        }
+        a = B > 0.0 ? 0.5 * (lo + hi) : 0.0;
+
+        // --- loss: bisect the one-pole so partial K decays K times faster ---
+        double perPeriod = exp(-decayPerSec / f1);
+        double blo = 0.0, bhi = 0.95;
+        for (int it = 0; it < 30; it++) {
+            b = 0.5 * (blo + bhi);
+            double gk = onePoleGain(b, K * w1) / onePoleGain(b, w1);
+            double decayK = -log(perPeriod * gk) * f1;
+            if (decayK < decayPerSec * K) blo = b;
+            else bhi = b;
+        }
+        b = blo;
+        g = std::min(0.99999, perPeriod / onePoleGain(b, w1));
+
+        // --- integer + fractional delay for the fundamental ---
+        double rest = 2.0 * M_PI / w1 - filterDelay(a, b, w1);
+        length = std::clamp(int(rest - 0.5), 2, WG_MAX_DELAY);
+        double frac = std::clamp(rest - length, 0.0, 1.999);
+
+        for (Allpass1& ap : dispersion) ap = Allpass1{ a };
+        tuning = Allpass1{ (1.0 - frac) / (1.0 + frac) };
+        lp = 0.0;
+        pos = 0;
+    }
+
+    // Sawtooth initial displacement (partials at 1/k, same as the
+    // additive strings) smoothed by a one-pole at `brightHz`, which is
+    // how velocity limits the harmonic content.
+    void pluck(double amplitude, double brightHz, double sampleRate) {
+        for (int i = 0; i < length; i++) {
+            double x = -M_PI + 2.0 * M_PI * (i + 0.5) / length;
+            delay[i] = (float)(amplitude * x * 0.5);
+        }
+
+        double c = exp(-2.0 * M_PI * brightHz / sampleRate);
+        double s = delay[length - 1];
+        for (int pass = 0; pass < 2; pass++) {
+            for (int i = 0; i < length; i++) {
+                s = (1.0 - c) * delay[i] + c * s;
+                if (pass == 1) delay[i] = (float)s;
+            }
+        }
+    }
+
+    inline double process() {
+        double out = delay[pos];
+
+        lp = (1.0 - b) * out + b * lp;
+        double y = lp * g;
+        for (Allpass1& ap : dispersion)
+            y = ap.process(y);
+        y = tuning.process(y);
+
+        delay[pos] = (float)y;
+        if (++pos == length) pos = 0;
+        return out;
+    }
+
+private:
+    static double filterDelay(double a, double b, double w) {
+        return WG_DISPERSION * allpassDelay(a, w) + onePoleDelay(b, w);
+    }
+
+    // frequency of partial k over the fundamental for a loop tuned to w1
+    static double partialRatio(double a, double b, double w1, int k) {
+        double total = 2.0 * M_PI / w1;  // loop length in samples at w1
+        double fixed = total - filterDelay(a, b, w1);
+
+        // phase around the loop; the Thiran part is folded into `fixed`
+        // (its delay is nearly flat below Nyquist/2)
+        auto phase = [&](double w) {
+            return w * (fixed + filterDelay(a, b, w));
+        };
+
+        double lo = 0.0, hi = M_PI;
+        for (int it = 0; it < 50; it++) {
+            double mid = 0.5 * (lo + hi);
+            if (phase(mid) < 2.0 * M_PI * k) lo = mid;
+            else hi = mid;
+        }
+        return lo / w1;
+    }
+};
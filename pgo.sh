@@ -0,0 +1,44 @@
+#!/bin/sh
+# Profile-guided build of every target, compared with a plain one.
+#
+#   ./pgo.sh [BUILD_DIR] [cmake options...]     default build-pgo
+#
+# BUILD_DIR/base is the plain build, BUILD_DIR/pgo is built instrumented,
+# trained (the pgo-train target), then rebuilt with the profile. Both get
+# the same options, so the bench comparison at the end is PGO alone.
+# The profile-guided binaries are in BUILD_DIR/pgo.
+set -e
+
+out=${1:-build-pgo}
+[ $# -gt 0 ] && shift
+mkdir -p "$out"
+out=$(cd "$out" && pwd)
+jobs=$(nproc 2>/dev/null || echo 4)
+
+cmake -S . -B "$out/base" -DCYNTH_PGO=OFF "$@"
+cmake --build "$out/base" -j "$jobs"
+
+rm -rf "$out/pgo/pgo"
+cmake -S . -B "$out/pgo" -DCYNTH_PGO=GENERATE "$@"
+cmake --build "$out/pgo" -j "$jobs"
+cmake --build "$out/pgo" --target pgo-train
+cmake -S . -B "$out/pgo" -DCYNTH_PGO=USE "$@"
+cmake --build "$out/pgo" -j "$jobs"
+
+# the profiled binaries must still render the goldens exactly
+(cd cli-app && "$out/pgo/regress" > /dev/null) || {
+    echo "pgo: regress failed on the profile-guided build"; exit 1; }
+
+for b in mixer compress layers bass piano kick rt mod analysis; do
+    for build in base pgo; do
+        echo "==== $b: $build"
+        "$out/$build/bench" "$b"
+    done
+done
+
+# the trained path itself, on a longer run than the training one
+for build in base pgo; do
+    echo "==== render: groove x16, one thread: $build"
+    (cd cli-app && "$out/$build/render" --score scores/groove.txt \
+        --loop 16 --threads 1 -o /dev/null) | grep thread
+done